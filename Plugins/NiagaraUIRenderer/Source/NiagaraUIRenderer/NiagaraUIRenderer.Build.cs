@@ -27,6 +27,7 @@ public class NiagaraUIRenderer : ModuleRules
 			{
 				"Core",
 				"UMG",
+				"DeveloperSettings",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -40,6 +41,8 @@ public class NiagaraUIRenderer : ModuleRules
 				"Slate",
 				"SlateCore",
 				"Niagara",
+				"RenderCore",
+				"Projects",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
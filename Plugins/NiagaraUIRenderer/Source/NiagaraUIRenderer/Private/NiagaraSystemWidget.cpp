@@ -5,8 +5,9 @@
 #include "NiagaraSystem.h"
 #include "SNiagaraUISystemWidget.h"
 #include "Materials/MaterialInterface.h"
-#include "NiagaraUIActor.h"
+#include "NiagaraUISubsystem.h"
 #include "NiagaraUIComponent.h"
+#include "NiagaraUIBakedEffect.h"
 #include "Engine/World.h"
 
 UNiagaraSystemWidget::UNiagaraSystemWidget(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
@@ -28,30 +29,65 @@ TSharedRef<SWidget> UNiagaraSystemWidget::RebuildWidget()
 
 void UNiagaraSystemWidget::SynchronizeProperties()
 {
+	bIsVolatile = !NonVolatile;
+	
 	Super::SynchronizeProperties();
 
 	if (!NiagaraSlateWidget.IsValid())
 		return;
 
-	if (!NiagaraActor || !NiagaraComponent)
+	WaitForAsyncRenderData();
+
+	if (!NiagaraComponent && !BakedEffect)
 		InitializeNiagaraUI();
 	
 	NiagaraSlateWidget->SetDesiredSize(DesiredWidgetSize);
 	NiagaraSlateWidget->SetColorAndOpacity(ColorAndOpacity);
-	NiagaraSlateWidget->SetNiagaraWidgetProperties(FNiagaraWidgetProperties(&MaterialRemapList, AutoActivate, ShowDebugSystemInWorld, PassDynamicParametersFromRibbon, FakeDepthScale, FakeDepthScaleDistance));
+	FNiagaraWidgetProperties WidgetProperties(&MaterialRemapList, AutoActivate, ShowDebugSystemInWorld, PassDynamicParametersFromRibbon, FakeDepthScale, FakeDepthScaleDistance);
+	WidgetProperties.RenderBufferShrinkDelay = RenderBufferShrinkDelay;
+	WidgetProperties.MinParticleScreenSize = MinParticleScreenSize;
+	WidgetProperties.ThinSubPixelParticles = SubPixelMode == ENiagaraUISubPixelMode::Thin;
+	WidgetProperties.BudgetPriority = BudgetPriority;
+	WidgetProperties.UseParticleSnapshot = UseParticleSnapshot;
+	WidgetProperties.UseInstancedSprites = UseInstancedSprites;
+	
+	NiagaraSlateWidget->SetNiagaraWidgetProperties(WidgetProperties);
+	NiagaraSlateWidget->SetNonVolatile(NonVolatile);
+
+	if (NiagaraComponent && ConfiguresSimulation)
+	{
+		NiagaraComponent->SetHiddenPolicy(HiddenPolicy, HiddenFramesToSuspend);
+		NiagaraComponent->SetSimulationRate(SimulationRate);
+	}
 }
 
 void UNiagaraSystemWidget::ReleaseSlateResources(bool bReleaseChildren)
 {
+	WaitForAsyncRenderData();
+	
 	Super::ReleaseSlateResources(bReleaseChildren);
 	
 	NiagaraSlateWidget.Reset();
 
-	if (NiagaraActor)
-		NiagaraActor->Destroy();
+	ReleaseNiagaraComponent();
+}
+
+void UNiagaraSystemWidget::ReleaseNiagaraComponent()
+{
+	if (NiagaraComponent)
+	{
+		if (UNiagaraUISubsystem* Subsystem = UWorld::GetSubsystem<UNiagaraUISubsystem>(NiagaraComponent->GetWorld()))
+			Subsystem->ReleaseComponent(NiagaraComponent);
+	}
 
-	NiagaraActor = nullptr;
 	NiagaraComponent = nullptr;
+	ConfiguresSimulation = false;
+}
+
+void UNiagaraSystemWidget::WaitForAsyncRenderData() const
+{
+	if (UNiagaraUISubsystem* Subsystem = UWorld::GetSubsystem<UNiagaraUISubsystem>(GetWorld()))
+		Subsystem->WaitForAsyncRenderData();
 }
 
 #if WITH_EDITOR
@@ -67,6 +103,7 @@ void UNiagaraSystemWidget::PostEditChangeProperty(FPropertyChangedEvent& Propert
 	{
 		const FName PropertyName = PropertyChangedEvent.MemberProperty->GetFName();
 		if (PropertyName == GET_MEMBER_NAME_CHECKED(UNiagaraSystemWidget, NiagaraSystemReference)
+			|| PropertyName == GET_MEMBER_NAME_CHECKED(UNiagaraSystemWidget, BakedEffect)
 			|| PropertyName == GET_MEMBER_NAME_CHECKED(UNiagaraSystemWidget, AutoActivate)
 			|| RestartSimulationOnPropertyChange
 				&& (PropertyName == GET_MEMBER_NAME_CHECKED(UNiagaraSystemWidget, MaterialRemapList)
@@ -85,40 +122,83 @@ void UNiagaraSystemWidget::PostEditChangeProperty(FPropertyChangedEvent& Propert
 
 void UNiagaraSystemWidget::InitializeNiagaraUI()
 {
+	if (!NiagaraSlateWidget.IsValid())
+		return;
+
+	WaitForAsyncRenderData();
+	
+	if (BakedEffect)
+	{
+		// Baked playback needs neither a world nor a simulation
+		NiagaraSlateWidget->SetBakedEffect(BakedEffect, AutoActivate);
+		ReleaseNiagaraComponent();
+		return;
+	}
+
+	NiagaraSlateWidget->SetBakedEffect(nullptr, false);
+
 	if (UWorld* World = GetWorld())
 	{
 		if(World->bIsTearingDown)
 			return;
 		
-		if (!World->PersistentLevel)
+		UNiagaraUISubsystem* Subsystem = World->GetSubsystem<UNiagaraUISubsystem>();
+
+		if (!Subsystem)
+			return;
+
+		if (NiagaraComponent)
+			Subsystem->ReleaseComponent(NiagaraComponent);
+
+		// All widgets of the world share one host actor owned by the subsystem
+		NiagaraComponent = Subsystem->AcquireSharedComponent(NiagaraSystemReference, SharedSimulationKey, AutoActivate, ShowDebugSystemInWorld, TickWhenPaused, &ConfiguresSimulation);
+
+		if (!NiagaraComponent)
 			return;
 
-			
-		if (!NiagaraActor)
+		if (ConfiguresSimulation)
 		{
-			FActorSpawnParameters SpawnParams;
-			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-			SpawnParams.ObjectFlags |= RF_Transient;
-			
-			NiagaraActor = World->SpawnActor<ANiagaraUIActor>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+			NiagaraComponent->SetHiddenPolicy(HiddenPolicy, HiddenFramesToSuspend);
+			NiagaraComponent->SetSimulationRate(SimulationRate);
 		}
 
-		NiagaraComponent = NiagaraActor->SpawnNewNiagaraUIComponent(NiagaraSystemReference, AutoActivate, ShowDebugSystemInWorld, TickWhenPaused);
-
 		NiagaraSlateWidget->SetNiagaraComponentReference(NiagaraComponent);
+		NiagaraSlateWidget->InvalidateRenderData();
 	}
 }
 
 void UNiagaraSystemWidget::ActivateSystem(bool Reset)
 {
+	WaitForAsyncRenderData();
+	
+	if (BakedEffect && NiagaraSlateWidget.IsValid())
+		NiagaraSlateWidget->PlayBakedEffect();
+	
 	if (NiagaraComponent)
-		NiagaraComponent->RequestActivateSystem(Reset);
+	{
+		NiagaraComponent->RequestActivateSystem(Reset && !NiagaraComponent->IsSharedSimulation());
+		NiagaraComponent->InvalidateWidgets();
+	}
+
+	if (NiagaraSlateWidget.IsValid())
+		NiagaraSlateWidget->InvalidateRenderData();
 }
 
 void UNiagaraSystemWidget::DeactivateSystem()
 {
+	WaitForAsyncRenderData();
+	
+	if (BakedEffect && NiagaraSlateWidget.IsValid())
+		NiagaraSlateWidget->StopBakedEffect();
+	
 	if (NiagaraComponent)
+	{
 		NiagaraComponent->RequestDeactivateSystem();
+		NiagaraComponent->InvalidateWidgets();
+	}
+
+	if (NiagaraSlateWidget.IsValid())
+		NiagaraSlateWidget->InvalidateRenderData();
 }
 
 UNiagaraUIComponent* UNiagaraSystemWidget::GetNiagaraComponent()
@@ -129,24 +209,50 @@ UNiagaraUIComponent* UNiagaraSystemWidget::GetNiagaraComponent()
 void UNiagaraSystemWidget::UpdateNiagaraSystemReference(UNiagaraSystem* NewNiagaraSystem)
 {
 	NiagaraSystemReference = NewNiagaraSystem;
+	WaitForAsyncRenderData();
 
+	// Other widgets keep rendering the old shared simulation, this one moves to the simulation of the new system
+	if (NiagaraComponent && NiagaraComponent->IsSharedSimulation())
+	{
+		if (NiagaraSlateWidget.IsValid())
+			InitializeNiagaraUI();
+		
+		return;
+	}
+	
 	if (NiagaraComponent)
 	{
 		NiagaraComponent->SetAsset(NewNiagaraSystem);
+		NiagaraComponent->InvalidateRendererCache();
 		NiagaraComponent->ResetSystem();
 	}
+
+	if (NiagaraSlateWidget.IsValid())
+		NiagaraSlateWidget->InvalidateRenderData();
+}
+
+void UNiagaraSystemWidget::UpdateBakedEffect(UNiagaraUIBakedEffect* NewBakedEffect)
+{
+	BakedEffect = NewBakedEffect;
+
+	if (NiagaraSlateWidget.IsValid())
+		InitializeNiagaraUI();
 }
 
 void UNiagaraSystemWidget::UpdateTickWhenPaused(bool NewTickWhenPaused)
 {
 	TickWhenPaused = NewTickWhenPaused;
+	WaitForAsyncRenderData();
 
-	if (NiagaraComponent)
+	if (NiagaraComponent && ConfiguresSimulation)
 	{
 		NiagaraComponent->SetTickableWhenPaused(NewTickWhenPaused);
-		NiagaraComponent->SetForceSolo(NewTickWhenPaused);
+		NiagaraComponent->UpdateForceSolo();
 		NiagaraComponent->ResetSystem();
 	}
+
+	if (NiagaraSlateWidget.IsValid())
+		NiagaraSlateWidget->InvalidateRenderData();
 }
 
 void UNiagaraSystemWidget::SetDesiredWidgetSize(FVector2D NewDesiredSize)
@@ -164,8 +270,13 @@ const FVector2D& UNiagaraSystemWidget::GetDesiredWidgetSize() const
 
 void UNiagaraSystemWidget::SetRemapMaterial(UMaterialInterface* OriginalMaterial, UMaterialInterface* RemapMaterial)
 {
+	WaitForAsyncRenderData();
+	
 	if (OriginalMaterial && RemapMaterial)
 		MaterialRemapList.Emplace(OriginalMaterial, RemapMaterial);
+
+	if (NiagaraSlateWidget.IsValid())
+		NiagaraSlateWidget->InvalidateRenderData();
 }
 
 UMaterialInterface* UNiagaraSystemWidget::GetRemapMaterial(UMaterialInterface* OriginalMaterial)
@@ -12,15 +12,7 @@ ANiagaraUIActor::ANiagaraUIActor()
 
 UNiagaraUIComponent* ANiagaraUIActor::SpawnNewNiagaraUIComponent(UNiagaraSystem* NiagaraSystemTemplate, bool AutoActivate, bool ShowDebugSystem, bool TickWhenPaused)
 {
-	// Find old component
-	TArray<UNiagaraUIComponent*> OldComponents;
-	GetComponents<UNiagaraUIComponent>(OldComponents);
-
-	// And destroy it
-	for (UNiagaraUIComponent* Component : OldComponents)
-		Component->DestroyComponent();
-	
-	
+	// The actor is shared by all widgets of the world, components are destroyed through UNiagaraUISubsystem::ReleaseComponent
 	UNiagaraUIComponent* NewComponent = NewObject<UNiagaraUIComponent>(this);
 	
 	// Don't use unreal activation, we'll do it ourself
@@ -33,11 +25,8 @@ UNiagaraUIComponent* ANiagaraUIActor::SpawnNewNiagaraUIComponent(UNiagaraSystem*
 	NewComponent->SetAsset(NiagaraSystemTemplate);	
 	NewComponent->SetAutoDestroy(false);
 
-	if (TickWhenPaused)
-	{
-		NewComponent->PrimaryComponentTick.bTickEvenWhenPaused = true;
-		NewComponent->SetForceSolo(true);
-	}
+	NewComponent->SetTickableWhenPaused(TickWhenPaused);
+	NewComponent->UpdateForceSolo();
 
 	return NewComponent;
 }
\ No newline at end of file
@@ -0,0 +1,349 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "NiagaraUIBakedEffect.h"
+#include "NiagaraUIComponent.h"
+#include "NiagaraUIRenderer.h"
+#include "NiagaraUIStats.h"
+#include "NiagaraUISpriteKernels.h"
+#include "NiagaraUISpriteIndexBuffer.h"
+#include "NiagaraUIConsoleVariables.h"
+#include "SNiagaraUISystemWidget.h"
+#include "Materials/MaterialInterface.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/MemStack.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_CYCLE_STAT(TEXT("Render Baked Frame"), STAT_NiagaraUIRenderBakedFrame, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Baked Sprites"), STAT_NiagaraUIBakedSprites, STATGROUP_NiagaraUI);
+
+namespace NiagaraUIBakedEffect
+{
+	constexpr int32 StreamComponents[(int32)ENiagaraUIBakedStream::Num] = { 3, 4, 2, 1, 1, 3, 4 };
+	constexpr int32 MaxComponentsPerParticle = 18;
+
+	int32 GetBytesPerValue(ENiagaraUIBakeQuantization Quantization)
+	{
+		switch (Quantization)
+		{
+		case ENiagaraUIBakeQuantization::Bits16:
+			return sizeof(uint16);
+		case ENiagaraUIBakeQuantization::Bits8:
+			return sizeof(uint8);
+		default:
+			return sizeof(float);
+		}
+	}
+
+	int32 GetMaxQuantizedValue(ENiagaraUIBakeQuantization Quantization)
+	{
+		return Quantization == ENiagaraUIBakeQuantization::Bits16 ? MAX_uint16 : MAX_uint8;
+	}
+
+	// Decodes all bound streams of the frame into consecutive component arrays and points the kernel streams at them
+	void DecodeFrame(const FNiagaraUIBakedSpriteRenderer& Renderer, const FNiagaraUIBakedFrame& Frame, ENiagaraUIBakeQuantization Quantization, float* OutData, FNiagaraUISpriteKernelParams& OutParams)
+	{
+		const int32 NumParticles = Frame.NumParticles;
+		const int32 BytesPerValue = GetBytesPerValue(Quantization);
+		const uint8* Source = Frame.Data.GetData();
+		int32 RangeIndex = 0;
+
+		for (int32 StreamIndex = 0; StreamIndex < (int32)ENiagaraUIBakedStream::Num; ++StreamIndex)
+		{
+			if ((Renderer.StreamMask & (1 << StreamIndex)) == 0)
+				continue;
+
+			float* const StreamData = OutData;
+
+			for (int32 Component = 0; Component < StreamComponents[StreamIndex]; ++Component)
+			{
+				if (Quantization == ENiagaraUIBakeQuantization::Float32)
+				{
+					FMemory::Memcpy(OutData, Source, NumParticles * sizeof(float));
+				}
+				else
+				{
+					const FVector2f Range = Frame.Ranges[RangeIndex++];
+
+					for (int32 Index = 0; Index < NumParticles; ++Index)
+					{
+						uint16 Value = Source[Index];
+						
+						if (Quantization == ENiagaraUIBakeQuantization::Bits16)
+							FMemory::Memcpy(&Value, Source + Index * sizeof(uint16), sizeof(uint16));
+						
+						OutData[Index] = Range.X + Value * Range.Y;
+					}
+				}
+
+				Source += NumParticles * BytesPerValue;
+				OutData += NumParticles;
+			}
+
+			const FNiagaraUIFloatStream Stream(StreamData, NumParticles, FNiagaraUIFloatStream::Zeros);
+
+			switch ((ENiagaraUIBakedStream)StreamIndex)
+			{
+			case ENiagaraUIBakedStream::Position:
+				OutParams.Position = Stream;
+				break;
+			case ENiagaraUIBakedStream::Color:
+				OutParams.Color = Stream;
+				break;
+			case ENiagaraUIBakedStream::Size:
+				OutParams.Size = Stream;
+				break;
+			case ENiagaraUIBakedStream::Rotation:
+				OutParams.Rotation = Stream;
+				break;
+			case ENiagaraUIBakedStream::SubImage:
+				OutParams.SubImage = Stream;
+				break;
+			case ENiagaraUIBakedStream::Alignment:
+				OutParams.Velocity = Stream;
+				OutParams.Alignment = Stream;
+				break;
+			case ENiagaraUIBakedStream::DynamicMaterial:
+				OutParams.DynamicMaterial = Stream;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	void LogMemoryReport()
+	{
+		SIZE_T TotalSize = 0;
+		int32 NumEffects = 0;
+
+		for (TObjectIterator<UNiagaraUIBakedEffect> It; It; ++It)
+		{
+			const UNiagaraUIBakedEffect* BakedEffect = *It;
+			const SIZE_T Size = BakedEffect->GetBakedDataSize();
+			
+			UE_LOG(LogNiagaraUIRenderer, Display, TEXT("%s: %d frames, %d max particles, %.1f KB"), *BakedEffect->GetPathName(), BakedEffect->GetNumFrames(), BakedEffect->MaxParticles, Size / 1024.f);
+
+			TotalSize += Size;
+			++NumEffects;
+		}
+
+		UE_LOG(LogNiagaraUIRenderer, Display, TEXT("%d baked effects loaded, %.1f KB total"), NumEffects, TotalSize / 1024.f);
+	}
+
+	static FAutoConsoleCommand MemoryReportCommand(
+		TEXT("niagaraui.BakedEffectMemoryReport"),
+		TEXT("Lists all loaded baked UI particle effects with their frame count and memory."),
+		FConsoleCommandDelegate::CreateStatic(&LogMemoryReport));
+}
+
+int32 UNiagaraUIBakedEffect::GetFrameIndex(double Time) const
+{
+	if (NumFrames < 1 || Time < 0.0)
+		return INDEX_NONE;
+
+	const int64 Frame = FMath::FloorToInt64(Time * FrameRate);
+
+	if (Loop)
+		return (int32)(Frame % NumFrames);
+
+	return Frame < NumFrames ? (int32)Frame : INDEX_NONE;
+}
+
+void UNiagaraUIBakedEffect::RenderFrame(SNiagaraUISystemWidget* NiagaraWidget, int32 FrameIndex, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UNiagaraUIBakedEffect::RenderFrame);
+	SCOPE_CYCLE_COUNTER(STAT_NiagaraUIRenderBakedFrame);
+
+	NiagaraWidget->ClearRenderData();
+
+	if (FrameIndex == INDEX_NONE)
+		return;
+
+	FMemMark Mark(FMemStack::Get());
+
+	for (const FNiagaraUIBakedSpriteRenderer& Renderer : SpriteRenderers)
+	{
+		if (!Renderer.Frames.IsValidIndex(FrameIndex))
+			continue;
+
+		const FNiagaraUIBakedFrame& Frame = Renderer.Frames[FrameIndex];
+
+		if (Frame.NumParticles < 1)
+			continue;
+
+		TArray<float, TMemStackAllocator<>> DecodedData;
+		DecodedData.AddUninitialized(Frame.NumParticles * NiagaraUIBakedEffect::MaxComponentsPerParticle);
+
+		FNiagaraUISpriteKernelParams KernelParams;
+		NiagaraUIBakedEffect::DecodeFrame(Renderer, Frame, BakedQuantization, DecodedData.GetData(), KernelParams);
+
+		// Baked frames have no particle IDs, so the cap picks the particles by an even stride
+		KernelParams.Orientation = (ENiagaraUISpriteOrientation)Renderer.Orientation;
+		const int32 ParticleCount = NiagaraUISpriteKernels::CapParticles(KernelParams, Frame.NumParticles, NiagaraUICVars::MaxParticlesPerRenderer);
+
+		FSlateVertex* VertexData;	
+		SlateIndex* IndexData;
+
+		NiagaraWidget->AddRenderData(&VertexData, &IndexData, Renderer.Material, ParticleCount * FNiagaraUISpriteIndexBuffer::VerticesPerSprite, ParticleCount * FNiagaraUISpriteIndexBuffer::IndicesPerSprite, true);
+
+		// The effect was recorded at the origin, so world space particles are only offset by the widget location
+		KernelParams.LocalSpace = Renderer.LocalSpace;
+		KernelParams.FakeDepthScale = WidgetProperties->FakeDepthScale;
+		KernelParams.ScaleFactor = RenderProperties.ScaleFactor;
+		KernelParams.ParentTopLeft = RenderProperties.ParentTopLeft;
+		KernelParams.Tint = RenderProperties.Tint;
+		KernelParams.ComponentScale = RenderProperties.WidgetScale;
+		KernelParams.ComponentOffset = RenderProperties.WidgetLocation * RenderProperties.ScaleFactor;
+		KernelParams.WidgetRotationAngle = RenderProperties.WidgetAngle;
+		KernelParams.WorldSpaceOffset = RenderProperties.WidgetLocation * RenderProperties.ScaleFactor;
+		KernelParams.FakeDepthScaleDistance = WidgetProperties->FakeDepthScaleDistance;
+		KernelParams.SubImageSize = Renderer.SubImageSize;
+		KernelParams.MinScreenSize = FMath::Max(WidgetProperties->MinParticleScreenSize, NiagaraUICVars::MinParticleScreenSize);
+		KernelParams.ThinSubPixelParticles = WidgetProperties->ThinSubPixelParticles;
+		KernelParams.KeepFraction = RenderProperties.ParticleFraction;
+		KernelParams.VertexData = VertexData;
+
+		const int32 NumVisibleSprites = NiagaraUISpriteKernels::BuildSprites(KernelParams, IndexData, ParticleCount, RenderProperties.CullingRect);
+
+		if (NumVisibleSprites < ParticleCount)
+			NiagaraWidget->TrimRenderData(NumVisibleSprites * FNiagaraUISpriteIndexBuffer::VerticesPerSprite, NumVisibleSprites * FNiagaraUISpriteIndexBuffer::IndicesPerSprite);
+
+		INC_DWORD_STAT_BY(STAT_NiagaraUIBakedSprites, NumVisibleSprites);
+	}
+}
+
+SIZE_T UNiagaraUIBakedEffect::GetBakedDataSize() const
+{
+	SIZE_T Size = SpriteRenderers.GetAllocatedSize();
+
+	for (const FNiagaraUIBakedSpriteRenderer& Renderer : SpriteRenderers)
+	{
+		Size += Renderer.Frames.GetAllocatedSize();
+
+		for (const FNiagaraUIBakedFrame& Frame : Renderer.Frames)
+			Size += Frame.Data.GetAllocatedSize() + Frame.Ranges.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+void UNiagaraUIBakedEffect::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetBakedDataSize());
+}
+
+#if WITH_EDITOR
+void UNiagaraUIBakedEffect::BeginBake()
+{
+	SpriteRenderers.Reset();
+	BakedQuantization = Quantization;
+	NumFrames = 0;
+	MaxParticles = 0;
+	BakedDataSize = 0;
+}
+
+void UNiagaraUIBakedEffect::AddSpriteFrame(int32 FrameIndex, int32 RendererIndex, UMaterialInterface* Material, FVector2f SubImageSize, bool LocalSpace, const FNiagaraUISpriteKernelParams& Particles, int32 NumParticles)
+{
+	using namespace NiagaraUIBakedEffect;
+	
+	if (SpriteRenderers.Num() <= RendererIndex)
+		SpriteRenderers.SetNum(RendererIndex + 1);
+
+	FNiagaraUIBakedSpriteRenderer& Renderer = SpriteRenderers[RendererIndex];
+	Renderer.Material = Material;
+	Renderer.SubImageSize = SubImageSize;
+	Renderer.LocalSpace = LocalSpace;
+	Renderer.Orientation = (uint8)Particles.Orientation;
+
+	if (Renderer.Frames.Num() <= FrameIndex)
+		Renderer.Frames.SetNum(FrameIndex + 1);
+
+	FNiagaraUIBakedFrame& Frame = Renderer.Frames[FrameIndex];
+	Frame.NumParticles = NumParticles;
+	Frame.Ranges.Reset();
+	Frame.Data.Reset();
+
+	MaxParticles = FMath::Max(MaxParticles, NumParticles);
+	
+	if (NumParticles < 1)
+		return;
+
+	const bool Aligned = Particles.Orientation == ENiagaraUISpriteOrientation::Velocity || Particles.Orientation == ENiagaraUISpriteOrientation::Custom;
+	
+	const FNiagaraUIFloatStream* Streams[(int32)ENiagaraUIBakedStream::Num] =
+	{
+		&Particles.Position,
+		&Particles.Color,
+		&Particles.Size,
+		&Particles.Rotation,
+		&Particles.SubImage,
+		Particles.Orientation == ENiagaraUISpriteOrientation::Velocity ? &Particles.Velocity : &Particles.Alignment,
+		&Particles.DynamicMaterial
+	};
+
+	// Attributes are bound per emitter, so the mask is the same for every frame
+	Renderer.StreamMask = 0;
+
+	for (int32 StreamIndex = 0; StreamIndex < (int32)ENiagaraUIBakedStream::Num; ++StreamIndex)
+	{
+		if (Streams[StreamIndex]->IsBound() && (StreamIndex != (int32)ENiagaraUIBakedStream::Alignment || Aligned))
+			Renderer.StreamMask |= 1 << StreamIndex;
+	}
+
+	const int32 BytesPerValue = GetBytesPerValue(BakedQuantization);
+	const int32 MaxValue = GetMaxQuantizedValue(BakedQuantization);
+	
+	for (int32 StreamIndex = 0; StreamIndex < (int32)ENiagaraUIBakedStream::Num; ++StreamIndex)
+	{
+		if ((Renderer.StreamMask & (1 << StreamIndex)) == 0)
+			continue;
+
+		for (int32 Component = 0; Component < StreamComponents[StreamIndex]; ++Component)
+		{
+			const float* Values = Streams[StreamIndex]->GetComponentData(Component);
+			uint8* Target = &Frame.Data[Frame.Data.AddUninitialized(NumParticles * BytesPerValue)];
+
+			if (BakedQuantization == ENiagaraUIBakeQuantization::Float32)
+			{
+				FMemory::Memcpy(Target, Values, NumParticles * sizeof(float));
+				continue;
+			}
+
+			float Min = Values[0];
+			float Max = Values[0];
+
+			for (int32 Index = 1; Index < NumParticles; ++Index)
+			{
+				Min = FMath::Min(Min, Values[Index]);
+				Max = FMath::Max(Max, Values[Index]);
+			}
+
+			const float Step = (Max - Min) / MaxValue;
+			Frame.Ranges.Add(FVector2f(Min, Step));
+
+			for (int32 Index = 0; Index < NumParticles; ++Index)
+			{
+				const uint16 Value = Step > 0.f ? (uint16)FMath::Clamp(FMath::RoundToInt((Values[Index] - Min) / Step), 0, MaxValue) : 0;
+
+				if (BakedQuantization == ENiagaraUIBakeQuantization::Bits16)
+					FMemory::Memcpy(Target + Index * sizeof(uint16), &Value, sizeof(uint16));
+				else
+					Target[Index] = (uint8)Value;
+			}
+		}
+	}
+}
+
+void UNiagaraUIBakedEffect::EndBake(int32 NumBakedFrames)
+{
+	NumFrames = NumBakedFrames;
+
+	// Renderers whose emitter had no particles at the end get empty frames
+	for (FNiagaraUIBakedSpriteRenderer& Renderer : SpriteRenderers)
+		Renderer.Frames.SetNum(NumFrames);
+
+	BakedDataSize = GetBakedDataSize();
+}
+#endif
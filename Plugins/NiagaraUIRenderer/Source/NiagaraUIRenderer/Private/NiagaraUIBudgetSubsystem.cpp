@@ -0,0 +1,150 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "NiagaraUIBudgetSubsystem.h"
+#include "NiagaraUIRenderer.h"
+#include "NiagaraUIStats.h"
+#include "NiagaraUIConsoleVariables.h"
+#include "Misc/CoreDelegates.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Budget Requested Vertices"), STAT_NiagaraUIBudgetRequestedVertices, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Budget Granted Vertices"), STAT_NiagaraUIBudgetGrantedVertices, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Budget Thinned Widgets"), STAT_NiagaraUIBudgetThinnedWidgets, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Budget Skipped Widgets"), STAT_NiagaraUIBudgetSkippedWidgets, STATGROUP_NiagaraUI);
+
+void UNiagaraUIBudgetSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddUObject(this, &UNiagaraUIBudgetSubsystem::OnBeginFrame);
+}
+
+void UNiagaraUIBudgetSubsystem::Deinitialize()
+{
+	FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+	
+	Requests.Empty();
+	GrantedFractions.Empty();
+	
+	Super::Deinitialize();
+}
+
+float UNiagaraUIBudgetSubsystem::GetGrantedFraction(const SNiagaraUISystemWidget* Widget) const
+{
+	const float* GrantedFraction = GrantedFractions.Find(Widget);
+	return GrantedFraction ? *GrantedFraction : 1.f;
+}
+
+void UNiagaraUIBudgetSubsystem::RequestBudget(const SNiagaraUISystemWidget* Widget, int32 Priority, float ScreenArea, int32 NumVertices, int32 NumDraws, bool Retained)
+{
+	FBudgetRequest& Request = Requests.FindOrAdd(Widget);
+	Request.Widget = Widget;
+	Request.Priority = Priority;
+	Request.ScreenArea = ScreenArea;
+	Request.NumVertices = NumVertices;
+	Request.NumDraws = NumDraws;
+	Request.Retained = Retained;
+}
+
+void UNiagaraUIBudgetSubsystem::ReleaseBudget(const SNiagaraUISystemWidget* Widget)
+{
+	Requests.Remove(Widget);
+	GrantedFractions.Remove(Widget);
+}
+
+void UNiagaraUIBudgetSubsystem::OnBeginFrame()
+{
+	GrantedFractions.Reset();
+	
+	const int32 VertexBudget = NiagaraUICVars::VertexBudget;
+	const int32 DrawBudget = NiagaraUICVars::DrawBudget;
+
+	if (Requests.Num() == 0 || (VertexBudget <= 0 && DrawBudget <= 0))
+	{
+		ReleaseFrameRequests();
+		return;
+	}
+
+	TArray<FBudgetRequest> SortedRequests;
+	Requests.GenerateValueArray(SortedRequests);
+
+	// Higher priority first, bigger widgets first within the same priority
+	SortedRequests.Sort([](const FBudgetRequest& A, const FBudgetRequest& B)
+	{
+		return A.Priority != B.Priority ? A.Priority > B.Priority : A.ScreenArea > B.ScreenArea;
+	});
+
+	const float MinFraction = FMath::Clamp(NiagaraUICVars::BudgetMinFraction, 0.f, 1.f);
+	
+	int64 RemainingVertices = VertexBudget;
+	int64 RemainingDraws = DrawBudget;
+	int64 RequestedVertices = 0;
+	int64 GrantedVertices = 0;
+	int32 NumThinnedWidgets = 0;
+	int32 NumSkippedWidgets = 0;
+
+	for (const FBudgetRequest& Request : SortedRequests)
+	{
+		RequestedVertices += Request.NumVertices;
+		
+		float Fraction = 1.f;
+
+		if (DrawBudget > 0 && Request.NumDraws > RemainingDraws)
+		{
+			Fraction = 0.f;
+		}
+		else if (VertexBudget > 0 && Request.NumVertices > RemainingVertices)
+		{
+			Fraction = (float)RemainingVertices / Request.NumVertices;
+
+			if (Fraction < MinFraction)
+				Fraction = 0.f;
+		}
+
+		if (Fraction <= 0.f)
+		{
+			++NumSkippedWidgets;
+		}
+		else
+		{
+			if (Fraction < 1.f)
+				++NumThinnedWidgets;
+			
+			const int32 NumGrantedVertices = FMath::CeilToInt(Request.NumVertices * Fraction);
+			
+			RemainingVertices = FMath::Max<int64>(RemainingVertices - NumGrantedVertices, 0);
+			RemainingDraws -= Request.NumDraws;
+			GrantedVertices += NumGrantedVertices;
+		}
+
+		GrantedFractions.Add(Request.Widget, Fraction);
+	}
+
+	INC_DWORD_STAT_BY(STAT_NiagaraUIBudgetRequestedVertices, RequestedVertices);
+	INC_DWORD_STAT_BY(STAT_NiagaraUIBudgetGrantedVertices, GrantedVertices);
+	INC_DWORD_STAT_BY(STAT_NiagaraUIBudgetThinnedWidgets, NumThinnedWidgets);
+	INC_DWORD_STAT_BY(STAT_NiagaraUIBudgetSkippedWidgets, NumSkippedWidgets);
+
+	if (NumThinnedWidgets > 0 || NumSkippedWidgets > 0)
+	{
+		const double CurrentTime = FPlatformTime::Seconds();
+
+		if (CurrentTime - LastOverBudgetLogTime >= NiagaraUICVars::BudgetLogInterval)
+		{
+			UE_LOG(LogNiagaraUIRenderer, Warning, TEXT("Niagara UI budget exceeded: %lld vertices requested, %d vertex budget, %d draw budget. %d widgets thinned, %d widgets skipped."),
+				RequestedVertices, VertexBudget, DrawBudget, NumThinnedWidgets, NumSkippedWidgets);
+			
+			LastOverBudgetLogTime = CurrentTime;
+		}
+	}
+
+	ReleaseFrameRequests();
+}
+
+void UNiagaraUIBudgetSubsystem::ReleaseFrameRequests()
+{
+	for (auto RequestIt = Requests.CreateIterator(); RequestIt; ++RequestIt)
+	{
+		if (!RequestIt.Value().Retained)
+			RequestIt.RemoveCurrent();
+	}
+}
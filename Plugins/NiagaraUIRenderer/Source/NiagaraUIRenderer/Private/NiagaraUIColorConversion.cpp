@@ -0,0 +1,24 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "NiagaraUIColorConversion.h"
+
+const uint8* FNiagaraUIColorConversion::GetTable()
+{
+	struct FTable
+	{
+		FTable()
+		{
+			// Entries come from the engine's own conversion, so the table only adds the 12-bit quantization of the input
+			for (int32 Index = 0; Index < TableSize; ++Index)
+			{
+				const float Value = (float)Index / (TableSize - 1);
+				Values[Index] = FLinearColor(Value, Value, Value).ToFColor(true).R;
+			}
+		}
+		
+		uint8 Values[TableSize];
+	};
+
+	static const FTable Table;
+	return Table.Values;
+}
@@ -0,0 +1,34 @@
+// Copyright 2024 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Linear to sRGB FColor conversion for the vertex builders. RGB goes through a 12-bit lookup table instead of the per-channel pow,
+ * alpha is quantized the same way as FLinearColor::ToFColor
+ */
+class FNiagaraUIColorConversion
+{
+public:
+	static constexpr int32 TableSize = 4096;
+	
+	FORCEINLINE static FColor ToFColorSRGB(const FLinearColor& Color, const FLinearColor& Tint)
+	{
+		const uint8* Table = GetTable();
+		
+		return FColor(
+			Table[Quantize(Color.R * Tint.R)],
+			Table[Quantize(Color.G * Tint.G)],
+			Table[Quantize(Color.B * Tint.B)],
+			(uint8)FMath::FloorToInt(FMath::Clamp(Color.A * Tint.A, 0.f, 1.f) * 255.999f));
+	}
+	
+private:
+	FORCEINLINE static int32 Quantize(float Value)
+	{
+		return FMath::Clamp(FMath::TruncToInt(Value * (TableSize - 1) + 0.5f), 0, TableSize - 1);
+	}
+	
+	static const uint8* GetTable();
+};
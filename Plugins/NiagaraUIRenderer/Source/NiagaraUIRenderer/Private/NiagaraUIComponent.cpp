@@ -1,20 +1,78 @@
 // Copyright 2024 - Michal Smoleň
 
 #include "NiagaraUIComponent.h"
-#include "Stats/Stats.h"
+#include "NiagaraUIStats.h"
+#include "Algo/StableSort.h"
+#include "NiagaraEmitterInstance.h"
 #include "NiagaraRenderer.h"
 #include "NiagaraRibbonRendererProperties.h"
 #include "NiagaraSpriteRendererProperties.h"
 #include "NiagaraSystemInstanceController.h"
 #include "SNiagaraUISystemWidget.h"
+#include "NiagaraUISpriteIndexBuffer.h"
+#include "NiagaraUISpriteKernels.h"
+#include "NiagaraUIColorConversion.h"
+#include "NiagaraUICulling.h"
+#include "NiagaraUISubsystem.h"
+#include "Engine/World.h"
+#include "NiagaraUIConsoleVariables.h"
+#include "NiagaraUIBakedEffect.h"
+#include "Misc/MemStack.h"
+#include "Materials/MaterialInterface.h"
 
 
-DECLARE_STATS_GROUP(TEXT("NiagaraUI"), STATGROUP_NiagaraUI, STATCAT_Advanced);
 DECLARE_CYCLE_STAT(TEXT("Generate Sprite Data"), STAT_GenerateSpriteData, STATGROUP_NiagaraUI);
 DECLARE_CYCLE_STAT(TEXT("Generate Ribbon Data"), STAT_GenerateRibbonData, STATGROUP_NiagaraUI);
+DECLARE_CYCLE_STAT(TEXT("Capture Particle Snapshot"), STAT_CaptureParticleSnapshot, STATGROUP_NiagaraUI);
+DECLARE_CYCLE_STAT(TEXT("Render Particle Snapshot"), STAT_RenderParticleSnapshot, STATGROUP_NiagaraUI);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Emitted Sprites"), STAT_NiagaraUIEmittedSprites, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Culled Sprites"), STAT_NiagaraUICulledSprites, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Instanced Sprites"), STAT_NiagaraUIInstancedSprites, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Emitted Ribbon Segments"), STAT_NiagaraUIEmittedRibbonSegments, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Culled Ribbon Segments"), STAT_NiagaraUICulledRibbonSegments, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Snapshot Particles"), STAT_NiagaraUISnapshotParticles, STATGROUP_NiagaraUI);
+
 
 //PRAGMA_DISABLE_OPTIMIZATION
 
+static const FNiagaraDataSet& GetParticleDataSet(const FNiagaraEmitterInstance& EmitterInst)
+{
+#if ENGINE_MINOR_VERSION < 4
+	return EmitterInst.GetData();
+#else
+	return EmitterInst.GetParticleData();
+#endif
+}
+
+static bool IsEmitterLocalSpace(const FNiagaraEmitterInstance& EmitterInst)
+{
+#if ENGINE_MINOR_VERSION < 1		
+	return EmitterInst.GetCachedEmitter()->bLocalSpace;
+#elif ENGINE_MINOR_VERSION < 4
+	return EmitterInst.GetCachedEmitterData()->bLocalSpace;
+#else
+	return EmitterInst.GetVersionedEmitter().GetEmitterData()->bLocalSpace;
+#endif
+}
+
+static ENiagaraUISpriteOrientation GetSpriteOrientation(const UNiagaraSpriteRendererProperties* SpriteRenderer, const FNiagaraUISpriteKernelParams& KernelParams)
+{
+	if (SpriteRenderer->Alignment == ENiagaraSpriteAlignment::VelocityAligned)
+		return ENiagaraUISpriteOrientation::Velocity;
+	
+	if (SpriteRenderer->Alignment == ENiagaraSpriteAlignment::CustomAlignment)
+		return ENiagaraUISpriteOrientation::Custom;
+	
+	return KernelParams.Rotation.IsBound() ? ENiagaraUISpriteOrientation::Rotation : ENiagaraUISpriteOrientation::NoRotation;
+}
+
+// Disabled, complete and empty emitters are skipped before any renderer work
+static bool HasEmitterParticlesToRender(const FNiagaraEmitterInstance& EmitterInst)
+{
+	return !EmitterInst.IsDisabled() && !EmitterInst.IsComplete() && EmitterInst.GetNumParticles() > 0;
+}
+
 void UNiagaraUIComponent::SetAutoActivateParticle(bool AutoActivate)
 {
 	AutoActivateParticle = AutoActivate;
@@ -45,9 +103,8 @@ void UNiagaraUIComponent::SetTransformationForUIRendering(FVector2D Location, FV
 	const FVector NewScale(Scale.X, 1.f, Scale.Y);
 	const FRotator NewRotation(Angle, 0.f, 0.f);;
 	
-	WidgetRotationAngle = Angle;
-	
-	SetRelativeTransform(FTransform(NewRotation, NewLocation, NewScale));
+	if (!SharedSimulation || !HasSetTransform)
+		SetRelativeTransform(FTransform(NewRotation, NewLocation, NewScale));
 
 	if (AutoActivateParticle)
 	{
@@ -60,356 +117,616 @@ void UNiagaraUIComponent::SetTransformationForUIRendering(FVector2D Location, FV
 	HasSetTransform = true;
 }
 
-#if ENGINE_MINOR_VERSION < 1
-struct FNiagaraRendererEntry
-{
-	FNiagaraRendererEntry(UNiagaraRendererProperties* PropertiesIn, TSharedRef<const FNiagaraEmitterInstance> EmitterInstIn, UNiagaraEmitter* EmitterIn)
-		: RendererProperties(PropertiesIn), EmitterInstance(EmitterInstIn), Emitter(EmitterIn) {}
-	UNiagaraRendererProperties* RendererProperties;
-	TSharedRef<const FNiagaraEmitterInstance> EmitterInstance;
-	UNiagaraEmitter* Emitter;
-};
-#else
-struct FNiagaraRendererEntry
-{
-	FNiagaraRendererEntry(UNiagaraRendererProperties* PropertiesIn, TSharedRef<const FNiagaraEmitterInstance> EmitterInstIn, FVersionedNiagaraEmitter EmitterIn)
-		: RendererProperties(PropertiesIn), EmitterInstance(EmitterInstIn), Emitter(EmitterIn) {}
-	UNiagaraRendererProperties* RendererProperties;
-	TSharedRef<const FNiagaraEmitterInstance> EmitterInstance;
-	FVersionedNiagaraEmitter Emitter;
-};
-#endif
-
-void UNiagaraUIComponent::RenderUI(SNiagaraUISystemWidget* NiagaraWidget, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties)
+FNiagaraUISimulationState UNiagaraUIComponent::GetSimulationState()
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(UNiagaraUIComponent::RenderUI);
+	FNiagaraUISimulationState State;
+	State.IsActive = IsActive();
+	State.RendererCacheDirty = RendererCacheDirty;
+	State.InterpolationAlpha = InterpolationAlpha;
 
-	NiagaraWidget->ClearRenderData();
+	if (GetSystemInstanceController())
+	{
+		if (const FNiagaraSystemInstance* SystemInstance = GetSystemInstanceController()->GetSystemInstance_Unsafe())
+		{
+			State.SystemInstance = SystemInstance;
+			State.TickCount = SystemInstance->GetTickCount();
+			State.Age = SystemInstance->GetAge();
+		}
+	}
 
-	if (!IsActive())
-		return;
+	return State;
+}
 
-	if (!GetSystemInstanceController())
-		return;
-	
-	TArray<FNiagaraRendererEntry> Renderers;
+bool UNiagaraUIComponent::HasParticlesToRender()
+{
+	if (!IsActive() || !GetSystemInstanceController())
+		return false;
 
-	for(TSharedRef<const FNiagaraEmitterInstance> EmitterInst : GetSystemInstanceController()->GetSystemInstance_Unsafe()->GetEmitters())
-	{
-		if (EmitterInst->IsDisabled())
-			continue;
-			
-#if ENGINE_MINOR_VERSION < 1
-		if (UNiagaraEmitter* Emitter = EmitterInst->GetCachedEmitter())
-		{
-			TArray<UNiagaraRendererProperties*> Properties = Emitter->GetRenderers();
+	const FNiagaraSystemInstance* SystemInstance = GetSystemInstanceController()->GetSystemInstance_Unsafe();
 
-			for (UNiagaraRendererProperties* Property : Properties)
-			{
-				FNiagaraRendererEntry NewEntry(Property, EmitterInst, Emitter);
-                Renderers.Add(NewEntry);
-			}
-		}
-#else
-		#if ENGINE_MINOR_VERSION < 4
-			FVersionedNiagaraEmitter Emitter = EmitterInst->GetCachedEmitter();
-		#else
-			FVersionedNiagaraEmitter Emitter = EmitterInst->GetVersionedEmitter();
-		#endif
+	if (!SystemInstance)
+		return false;
 
-		if (Emitter.Emitter)
-		{
-			TArray<UNiagaraRendererProperties*> Properties = Emitter.GetEmitterData()->GetRenderers();
+	UpdateRendererCache(*SystemInstance);
 
-			for (UNiagaraRendererProperties* Property : Properties)
-			{
-				FNiagaraRendererEntry NewEntry(Property, EmitterInst, Emitter);
-				Renderers.Add(NewEntry);
-			}
-		}
-#endif
-	}
+	const auto& Emitters = SystemInstance->GetEmitters();
 
-	Algo::Sort(Renderers, [] (FNiagaraRendererEntry& FirstElement, FNiagaraRendererEntry& SecondElement) {return FirstElement.RendererProperties->SortOrderHint < SecondElement.RendererProperties->SortOrderHint;});
-			
-	for (FNiagaraRendererEntry Renderer : Renderers)
+	for (const FNiagaraUIRendererEntry& Renderer : CachedRenderers)
 	{
-#if ENGINE_MINOR_VERSION < 1
-		if (Renderer.RendererProperties && Renderer.RendererProperties->GetIsEnabled() && Renderer.RendererProperties->IsSimTargetSupported(Renderer.Emitter->SimTarget))
-		{
-			if (Renderer.Emitter->SimTarget == ENiagaraSimTarget::CPUSim)
-			{
-#else
-		if (Renderer.RendererProperties && Renderer.RendererProperties->GetIsEnabled() && Renderer.RendererProperties->IsSimTargetSupported(Renderer.Emitter.GetEmitterData()->SimTarget))
-		{
-			if (Renderer.Emitter.GetEmitterData()->SimTarget == ENiagaraSimTarget::CPUSim)
-			{
-#endif
-				
-				if (UNiagaraSpriteRendererProperties* SpriteRenderer = Cast<UNiagaraSpriteRendererProperties>(Renderer.RendererProperties))
-				{
-					AddSpriteRendererData(NiagaraWidget, Renderer.EmitterInstance, SpriteRenderer, RenderProperties, WidgetProperties);
-				}
-				else if (UNiagaraRibbonRendererProperties* RibbonRenderer = Cast<UNiagaraRibbonRendererProperties>(Renderer.RendererProperties))
-				{
-					AddRibbonRendererData(NiagaraWidget, Renderer.EmitterInstance, RibbonRenderer, RenderProperties, WidgetProperties);                		
-				}
-			}
-		}
+		const FNiagaraEmitterInstance& EmitterInst = Emitters[Renderer.EmitterIndex].Get();
+
+		if (HasEmitterParticlesToRender(EmitterInst))
+			return true;
 	}
+
+	return false;
 }
 
-FORCEINLINE FVector2D FastRotate(const FVector2D Vector, float Sin, float Cos)
+void UNiagaraUIComponent::InvalidateRendererCache()
 {
-	return FVector2D(Cos * Vector.X - Sin * Vector.Y,
-                     Sin * Vector.X + Cos * Vector.Y);
+	RendererCacheDirty = true;
 }
 
+void UNiagaraUIComponent::SetHiddenPolicy(ENiagaraUIHiddenPolicy Policy, int32 HiddenFrames)
+{
+	if (Suspended && Policy != HiddenPolicy)
+		Resume();
+	
+	HiddenPolicy = Policy;
+	HiddenFramesToSuspend = FMath::Max(HiddenFrames, 1);
+}
 
-void UNiagaraUIComponent::AddSpriteRendererData(SNiagaraUISystemWidget* NiagaraWidget, TSharedRef<const FNiagaraEmitterInstance> EmitterInst, UNiagaraSpriteRendererProperties* SpriteRenderer, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties)
+void UNiagaraUIComponent::MarkWidgetVisible()
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(UNiagaraUIComponent::AddSpriteRendererData);
-	SCOPE_CYCLE_COUNTER(STAT_GenerateSpriteData);
-	FVector ComponentLocation = GetRelativeLocation();
-	FVector ComponentScale = GetRelativeScale3D();
-	float WidgetRotationAngleRadians = FMath::DegreesToRadians(WidgetRotationAngle);
+	LastVisibleFrame = GFrameCounter;
+
+	if (Suspended)
+		Resume();
+}
+
+void UNiagaraUIComponent::UpdateHiddenState()
+{
+	if (NiagaraUICVars::SuspendHiddenWidgets == 0)
+	{
+		if (Suspended)
+			Resume();
 
-#if ENGINE_MINOR_VERSION < 4
-	FNiagaraDataSet& DataSet = EmitterInst->GetData();
-#else
-	const FNiagaraDataSet& DataSet = EmitterInst->GetParticleData();
-#endif
-			
-	
-	if (!DataSet.IsCurrentDataValid())
 		return;
+	}
 	
-	FNiagaraDataBuffer& ParticleData = DataSet.GetCurrentDataChecked();
-	const int32 ParticleCount = ParticleData.GetNumInstances();
-
-	if (ParticleCount < 1)
+	if (Suspended || HiddenPolicy == ENiagaraUIHiddenPolicy::KeepSimulating)
 		return;
 
-	const float& ScaleFactor = RenderProperties.ScaleFactor;
-	const FVector2f& ParentTopLeft = RenderProperties.ParentTopLeft;
-	const FLinearColor& Tint = RenderProperties.Tint;
+	if (GFrameCounter - LastVisibleFrame > (uint64)HiddenFramesToSuspend)
+		Suspend();
+}
+
+void UNiagaraUIComponent::OnReturnedToPool()
+{
+	Suspended = false;
+	Pooled = true;
+	SharedSimulation = false;
+	Widgets.Reset();
+	HiddenPolicy = ENiagaraUIHiddenPolicy::KeepSimulating;
+	AutoActivateParticle = false;
+	HasSetTransform = false;
+	SetSimulationRate(0.f);
+
+	SetPaused(false);
+	DeactivateImmediate();
+	SetHiddenInGame(true);
+
+	// The next owner starts from the same placement as a newly spawned component, its first paint sets the transform again
+	SetRelativeTransform(FTransform::Identity);
+}
 
+void UNiagaraUIComponent::OnReusedFromPool(bool AutoActivate, bool ShowDebugSystem, bool TickWhenPaused)
+{
+	Pooled = false;
+	LastVisibleFrame = GFrameCounter;
 	
-#if ENGINE_MINOR_VERSION < 1		
-	bool LocalSpace = EmitterInst->GetCachedEmitter()->bLocalSpace;
-#elif ENGINE_MINOR_VERSION < 4
-	bool LocalSpace = EmitterInst->GetCachedEmitterData()->bLocalSpace;
-#else
-	bool LocalSpace = EmitterInst->GetVersionedEmitter().GetEmitterData()->bLocalSpace;
-#endif
-			
+	// User parameters set by the previous owner would otherwise leak into the next one
+	SetUserParametersToDefaultValues();
+
+	SetHiddenInGame(!ShowDebugSystem);
+	SetAutoActivateParticle(AutoActivate);
+	SetTickableWhenPaused(TickWhenPaused);
+	UpdateForceSolo();
+	InvalidateRendererCache();
+}
 
-	const float FakeDepthScaler = 1 / WidgetProperties->FakeDepthScaleDistance;
+void UNiagaraUIComponent::SetSharedSimulation(bool Shared)
+{
+	SharedSimulation = Shared;
+}
 
-	FVector2D SubImageSize = SpriteRenderer->SubImageSize;
-	FVector2D SubImageDelta = FVector2D::UnitVector / SubImageSize;
+void UNiagaraUIComponent::SetSimulationRate(float Rate)
+{
+	Rate = FMath::Max(Rate, 0.f);
 
-	const auto PositionData			= FNiagaraDataSetAccessor<FNiagaraPosition>::	CreateReader(DataSet, SpriteRenderer->PositionBinding.GetDataSetBindableVariable().GetName());
-	const auto ColorData			= FNiagaraDataSetAccessor<FLinearColor>::		CreateReader(DataSet, SpriteRenderer->ColorBinding.GetDataSetBindableVariable().GetName());
-	const auto VelocityData			= FNiagaraDataSetAccessor<FVector3f>::			CreateReader(DataSet, SpriteRenderer->VelocityBinding.GetDataSetBindableVariable().GetName());
-	const auto AlignmentData		= FNiagaraDataSetAccessor<FVector3f>::			CreateReader(DataSet, SpriteRenderer->SpriteAlignmentBinding.GetDataSetBindableVariable().GetName());
-	const auto SizeData				= FNiagaraDataSetAccessor<FVector2f>::			CreateReader(DataSet, SpriteRenderer->SpriteSizeBinding.GetDataSetBindableVariable().GetName());
-	const auto RotationData			= FNiagaraDataSetAccessor<float>::				CreateReader(DataSet, SpriteRenderer->SpriteRotationBinding.GetDataSetBindableVariable().GetName());
-	const auto SubImageData			= FNiagaraDataSetAccessor<float>::				CreateReader(DataSet, SpriteRenderer->SubImageIndexBinding.GetDataSetBindableVariable().GetName());
-	const auto DynamicMaterialData	= FNiagaraDataSetAccessor<FVector4f>::			CreateReader(DataSet, SpriteRenderer->DynamicMaterialBinding.GetDataSetBindableVariable().GetName());
+	if (Rate == SimulationRate)
+		return;
+	
+	SimulationRate = Rate;
+	InterpolationAlpha = 1.f;
+	HistoryTickCount = INDEX_NONE;
 
-	auto GetParticlePosition2D = [&PositionData](int32 Index)
+	// The component advances the desired age every frame and the system follows it in fixed steps
+	if (SimulationRate > 0.f)
 	{
-		const FVector3f Position3D = PositionData.GetSafe(Index, FVector3f::ZeroVector);
-		return FVector2f(Position3D.X, -Position3D.Z);
-	};
-	
-	auto GetParticleDepth = [&PositionData](int32 Index)
+		SetSeekDelta(1.f / SimulationRate);
+		SetAgeUpdateMode(ENiagaraAgeUpdateMode::DesiredAge);
+	}
+	else
 	{
-		return PositionData.GetSafe(Index, FVector::ZeroVector).Y;
-	};	
+		SetAgeUpdateMode(ENiagaraAgeUpdateMode::TickDeltaTime);
+	}
+
+	UpdateForceSolo();
+}
+
+void UNiagaraUIComponent::UpdateForceSolo()
+{
+	// Batched simulations are ticked by the Niagara world manager, which doesn't tick while the world is paused. Changing the solo mode
+	// destroys the system instance, so tick when paused simulations stay solo for their whole lifetime instead of following the pause
+	SetForceSolo(PrimaryComponentTick.bTickEvenWhenPaused || SimulationRate > 0.f);
+}
+
+void UNiagaraUIComponent::RegisterWidget(const TSharedRef<SNiagaraUISystemWidget>& Widget)
+{
+	Widgets.RemoveAllSwap([](const TWeakPtr<SNiagaraUISystemWidget>& Entry) { return !Entry.IsValid(); });
+	Widgets.AddUnique(TWeakPtr<SNiagaraUISystemWidget>(Widget));
+}
+
+void UNiagaraUIComponent::UnregisterWidget(const SNiagaraUISystemWidget* Widget)
+{
+	Widgets.RemoveAllSwap([Widget](const TWeakPtr<SNiagaraUISystemWidget>& Entry) { return !Entry.IsValid() || Entry.Pin().Get() == Widget; });
+}
 
-	auto GetParticleColor = [&ColorData, &Tint](int32 Index)
+void UNiagaraUIComponent::InvalidateWidgets()
+{
+	for (const TWeakPtr<SNiagaraUISystemWidget>& Entry : Widgets)
 	{
-		return ColorData.GetSafe(Index, FLinearColor::White) * Tint;
-	};
-	
-	auto GetParticleVelocity2D = [&VelocityData](int32 Index)
+		if (TSharedPtr<SNiagaraUISystemWidget> Widget = Entry.Pin())
+			Widget->InvalidateRenderData();
+	}
+}
+
+void UNiagaraUIComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	if (SimulationRate <= 0.f)
 	{
-		const FVector3f Velocity3D = VelocityData.GetSafe(Index, FVector3f::ZeroVector);
-		return FVector2D(Velocity3D.X, Velocity3D.Z);
-	};
-	
-	auto GetParticleAlignment2D = [&AlignmentData](int32 Index)
+		Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+		return;
+	}
+
+	const float SeekDelta = GetSeekDelta();
+	const FNiagaraSystemInstance* SystemInstance = GetSystemInstanceController() ? GetSystemInstanceController()->GetSystemInstance_Unsafe() : nullptr;
+
+	if (SystemInstance && IsActive() && !IsPaused())
 	{
-		const FVector3f Alignment3D = AlignmentData.GetSafe(Index, FVector3f::ZeroVector);
-		return FVector2D(Alignment3D.X, Alignment3D.Z);
-	};
+		const float Age = SystemInstance->GetAge();
+
+		// Leftover time is kept under one step, so restarted systems don't fast forward and the desired age never goes backwards, which would reset the system
+		const float DesiredAge = FMath::Clamp(GetDesiredAge(), Age, Age + SeekDelta) + DeltaTime;
+		SetDesiredAge(DesiredAge);
+
+		if (DesiredAge - Age >= SeekDelta)
+			CaptureParticleHistory(*SystemInstance);
+	}
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// Interpolation is only valid when the system advanced exactly one step since the history was captured
+	InterpolationAlpha = 1.f;
+	SystemInstance = GetSystemInstanceController() ? GetSystemInstanceController()->GetSystemInstance_Unsafe() : nullptr;
+
+	if (SystemInstance && HistoryTickCount != INDEX_NONE && SystemInstance->GetTickCount() == HistoryTickCount + 1)
+		InterpolationAlpha = FMath::Clamp((GetDesiredAge() - SystemInstance->GetAge()) / SeekDelta, 0.f, 1.f);
+}
+
+void UNiagaraUIComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	// Newly spawned components get the full number of frames to be painted for the first time
+	LastVisibleFrame = GFrameCounter;
 	
-	auto GetParticleSize = [&SizeData](int32 Index)
-	{
-		return SizeData.GetSafe(Index, FVector2f::UnitVector);
-	};
+	if (UNiagaraUISubsystem* Subsystem = UWorld::GetSubsystem<UNiagaraUISubsystem>(GetWorld()))
+		Subsystem->RegisterComponent(this);
+}
+
+void UNiagaraUIComponent::OnUnregister()
+{
+	if (UNiagaraUISubsystem* Subsystem = UWorld::GetSubsystem<UNiagaraUISubsystem>(GetWorld()))
+		Subsystem->UnregisterComponent(this);
 	
-	auto GetParticleRotation = [&RotationData](int32 Index)
+	Super::OnUnregister();
+}
+
+void UNiagaraUIComponent::Suspend()
+{
+	// Batched instances are ticked by the Niagara world manager regardless of the component tick, and the component tick itself follows
+	// the solo mode set in UpdateForceSolo. Pausing or deactivating the system stops both kinds of instances without touching the tick
+	Suspended = true;
+
+	if (HiddenPolicy == ENiagaraUIHiddenPolicy::Pause)
 	{
-		return RotationData.GetSafe(Index, 0.f);
-	};
-	
-	auto GetParticleSubImage = [&SubImageData](int32 Index)
+		WasPausedBeforeSuspend = IsPaused();
+		SetPaused(true);
+	}
+	else if (HiddenPolicy == ENiagaraUIHiddenPolicy::ResetOnShow)
 	{
-		return SubImageData.GetSafe(Index, 0.f);
-	};
-	
-	auto GetDynamicMaterialData = [&DynamicMaterialData](int32 Index)
+		WasActiveBeforeSuspend = IsActive();
+		DeactivateImmediate();
+	}
+}
+
+void UNiagaraUIComponent::Resume()
+{
+	Suspended = false;
+
+	if (HiddenPolicy == ENiagaraUIHiddenPolicy::Pause)
 	{
-		return DynamicMaterialData.GetSafe(Index, FVector4f(0.f, 0.f, 0.f, 0.f));
-	};
-	
-	FSlateVertex* VertexData;	
-	SlateIndex* IndexData;
-	
-	FSlateBrush Brush;
-	UMaterialInterface* SpriteMaterial = SpriteRenderer->Material;
+		SetPaused(WasPausedBeforeSuspend);
+	}
+	else if (HiddenPolicy == ENiagaraUIHiddenPolicy::ResetOnShow)
+	{
+		if (WasActiveBeforeSuspend)
+			RequestActivateSystem(true);
+	}
+}
 
-	NiagaraWidget->AddRenderData(&VertexData, &IndexData, SpriteMaterial, ParticleCount * 4, ParticleCount * 6);
+bool UNiagaraUIComponent::IsRendererCacheValid(const FNiagaraSystemInstance& SystemInstance) const
+{
+	if (RendererCacheDirty || CachedSystemInstanceID != SystemInstance.GetId())
+		return false;
 
-	for (int ParticleIndex = 0; ParticleIndex < ParticleCount; ++ParticleIndex)
+	// Recompiling or reinitializing the system recreates its emitter instances, so comparing them is enough to catch both
+	const auto& Emitters = SystemInstance.GetEmitters();
+
+	if (Emitters.Num() != CachedEmitterInstances.Num())
+		return false;
+
+	for (int32 EmitterIndex = 0; EmitterIndex < Emitters.Num(); ++EmitterIndex)
 	{
+		if (!CachedEmitterInstances[EmitterIndex].HasSameObject(&Emitters[EmitterIndex].Get()))
+			return false;
+	}
 
-		FVector2f ParticlePosition = GetParticlePosition2D(ParticleIndex) * ScaleFactor;
-		FVector2f ParticleSize = GetParticleSize(ParticleIndex) * ScaleFactor;
+	for (const FNiagaraUIRendererEntry& Renderer : CachedRenderers)
+	{
+		if (Renderer.Type == FNiagaraUIRendererEntry::EType::Sprite ? !Renderer.SpriteRenderer.IsValid() : !Renderer.RibbonRenderer.IsValid())
+			return false;
+	}
 
-		if (LocalSpace)
-		{
-			ParticlePosition *= FVector2f(ComponentScale.X, ComponentScale.Z);
-			ParticlePosition  = ParticlePosition.GetRotated(-WidgetRotationAngle);
-			ParticlePosition += ParentTopLeft;	
-			ParticlePosition += FVector2f(ComponentLocation.X, -ComponentLocation.Z) * ScaleFactor;
-			
-			ParticleSize *= FVector2f(ComponentScale.X, ComponentScale.Z);
-		}
-		else
-		{
-			ParticlePosition += ParentTopLeft;					
-		}
+	return true;
+}
 
+void UNiagaraUIComponent::UpdateRendererCache(const FNiagaraSystemInstance& SystemInstance)
+{
+	if (IsRendererCacheValid(SystemInstance))
+		return;
 
-		if (WidgetProperties->FakeDepthScale)
-		{
-			const float ParticleDepth = (-GetParticleDepth(ParticleIndex) + WidgetProperties->FakeDepthScaleDistance) * FakeDepthScaler;
-			ParticleSize *= ParticleDepth;
-		}
+	TRACE_CPUPROFILER_EVENT_SCOPE(UNiagaraUIComponent::UpdateRendererCache);
+	
+	CachedRenderers.Reset();
+	CachedEmitterInstances.Reset();
+	CachedSystemInstanceID = SystemInstance.GetId();
+	RendererCacheDirty = false;
 
+	const auto& Emitters = SystemInstance.GetEmitters();
+
+	for (int32 EmitterIndex = 0; EmitterIndex < Emitters.Num(); ++EmitterIndex)
+	{
+		const FNiagaraEmitterInstance& EmitterInst = Emitters[EmitterIndex].Get();
+		CachedEmitterInstances.Add(Emitters[EmitterIndex]);
 		
-		const FVector2f ParticleHalfSize = ParticleSize * 0.5;
-		
-		
-		const FColor ParticleColor = GetParticleColor(ParticleIndex).ToFColor(true);
-		
-		
-		float ParticleRotationSin, ParticleRotationCos;
+#if ENGINE_MINOR_VERSION < 1
+		const UNiagaraEmitter* EmitterData = EmitterInst.GetCachedEmitter();
+#elif ENGINE_MINOR_VERSION < 4
+		const FVersionedNiagaraEmitterData* EmitterData = EmitterInst.GetCachedEmitterData();
+#else
+		const FVersionedNiagaraEmitterData* EmitterData = EmitterInst.GetVersionedEmitter().GetEmitterData();
+#endif
+
+		// Only CPU particles can be rendered into the UI
+		if (!EmitterData || EmitterData->SimTarget != ENiagaraSimTarget::CPUSim)
+			continue;
 
-		if (SpriteRenderer->Alignment == ENiagaraSpriteAlignment::VelocityAligned || SpriteRenderer->Alignment == ENiagaraSpriteAlignment::CustomAlignment)
+		for (UNiagaraRendererProperties* RendererProperties : EmitterData->GetRenderers())
 		{
-			const FVector2D AlignmentVector = SpriteRenderer->Alignment == ENiagaraSpriteAlignment::VelocityAligned ? GetParticleVelocity2D(ParticleIndex) : GetParticleAlignment2D(ParticleIndex);
+			if (!RendererProperties || !RendererProperties->GetIsEnabled() || !RendererProperties->IsSimTargetSupported(EmitterData->SimTarget))
+				continue;
 
-			ParticleRotationCos = FVector2D::DotProduct(AlignmentVector.GetSafeNormal(), FVector2D(0.f, 1.f));
-			const float SinSign = FVector2D::DotProduct(AlignmentVector, FVector2D(1.f, 0.f)) >= 0.f ? 1.f : -1.f;
-		
-			if (LocalSpace)
+			FNiagaraUIRendererEntry NewEntry;
+			NewEntry.EmitterIndex = EmitterIndex;
+			NewEntry.SortOrderHint = RendererProperties->SortOrderHint;
+			
+			if (UNiagaraSpriteRendererProperties* SpriteRenderer = Cast<UNiagaraSpriteRendererProperties>(RendererProperties))
+			{
+				NewEntry.Type = FNiagaraUIRendererEntry::EType::Sprite;
+				NewEntry.SpriteRenderer = SpriteRenderer;
+				NewEntry.SpriteLayout.Resolve(GetParticleDataSet(EmitterInst), SpriteRenderer);
+			}
+			else if (UNiagaraRibbonRendererProperties* RibbonRenderer = Cast<UNiagaraRibbonRendererProperties>(RendererProperties))
 			{
-				const float ParticleRotation = FMath::Acos(ParticleRotationCos) * SinSign - WidgetRotationAngleRadians;
-				FMath::SinCos(&ParticleRotationSin, &ParticleRotationCos, ParticleRotation);				
+				NewEntry.Type = FNiagaraUIRendererEntry::EType::Ribbon;
+				NewEntry.RibbonRenderer = RibbonRenderer;
+				NewEntry.RibbonLayout.Resolve(GetParticleDataSet(EmitterInst), RibbonRenderer);
 			}
 			else
 			{
-				ParticleRotationSin = FMath::Sqrt(1 - ParticleRotationCos * ParticleRotationCos) * SinSign;
+				continue;
 			}
+
+			NewEntry.ParticleID.Resolve(GetParticleDataSet(EmitterInst), TEXT("ID"), 2);
+			CachedRenderers.Add(NewEntry);
 		}
-		else
-		{
-			float ParticleRotation = GetParticleRotation(ParticleIndex);
-			
-			if (LocalSpace)
-				ParticleRotation -= WidgetRotationAngle;
-			
-			FMath::SinCos(&ParticleRotationSin, &ParticleRotationCos, FMath::DegreesToRadians(ParticleRotation));
-		}
-		
-		
-		FVector2D TextureCoordinates[4];
+	}
+
+	Algo::StableSort(CachedRenderers, [] (const FNiagaraUIRendererEntry& FirstElement, const FNiagaraUIRendererEntry& SecondElement) { return FirstElement.SortOrderHint < SecondElement.SortOrderHint; });
+}
+
+void UNiagaraUIComponent::CaptureParticleHistory(const FNiagaraSystemInstance& SystemInstance)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UNiagaraUIComponent::CaptureParticleHistory);
+
+	UpdateRendererCache(SystemInstance);
+	HistoryTickCount = SystemInstance.GetTickCount();
+
+	const auto& Emitters = SystemInstance.GetEmitters();
+
+	for (FNiagaraUIRendererEntry& Renderer : CachedRenderers)
+	{
+		Renderer.PreviousAcquireTags.Reset();
+
+		const FNiagaraEmitterInstance& EmitterInst = Emitters[Renderer.EmitterIndex].Get();
+		const FNiagaraUIFloatAttribute& PositionAttribute = Renderer.Type == FNiagaraUIRendererEntry::EType::Sprite ? Renderer.SpriteLayout.Position : Renderer.RibbonLayout.Position;
+
+#if ENGINE_MINOR_VERSION < 4
+		FNiagaraDataSet& DataSet = EmitterInst.GetData();
+#else
+		const FNiagaraDataSet& DataSet = EmitterInst.GetParticleData();
+#endif
+
+		if (!Renderer.ParticleID.IsBound() || !PositionAttribute.IsBound() || !HasEmitterParticlesToRender(EmitterInst) || !DataSet.IsCurrentDataValid())
+			continue;
+
+		const FNiagaraDataBuffer& ParticleData = DataSet.GetCurrentDataChecked();
+		const FNiagaraUIFloatStream Position(ParticleData, PositionAttribute, FNiagaraUIFloatStream::Zeros);
+		const int32* IDIndices = reinterpret_cast<const int32*>(ParticleData.GetComponentPtrInt32(Renderer.ParticleID.ComponentStart));
+		const int32* IDTags = reinterpret_cast<const int32*>(ParticleData.GetComponentPtrInt32(Renderer.ParticleID.ComponentStart + 1));
+		const int32 NumParticles = ParticleData.GetNumInstances();
+
+		int32 NumIDs = 0;
 		
-		if (SubImageSize != FVector2D(1.f, 1.f))
+		for (int32 Index = 0; Index < NumParticles; ++Index)
+			NumIDs = FMath::Max(NumIDs, IDIndices[Index] + 1);
+
+		Renderer.PreviousPositions.SetNumUninitialized(NumIDs);
+		Renderer.PreviousAcquireTags.SetNumUninitialized(NumIDs);
+
+		// Free ID slots must not match the tag of a particle spawned into them later
+		for (int32& AcquireTag : Renderer.PreviousAcquireTags)
+			AcquireTag = INDEX_NONE;
+
+		for (int32 Index = 0; Index < NumParticles; ++Index)
 		{
-			const float ParticleSubImage = GetParticleSubImage(ParticleIndex);
-			const int Row = (int)FMath::Floor(ParticleSubImage / SubImageSize.X) % (int)SubImageSize.Y;
-			const int Column = (int)(ParticleSubImage) % (int)(SubImageSize.X);
-
-			const float LeftUV = SubImageDelta.X * Column;
-			const float Right = SubImageDelta.X * (Column + 1);
-			const float TopUV = SubImageDelta.Y * Row;
-			const float BottomUV = SubImageDelta.Y * (Row + 1);
-			
-			TextureCoordinates[0] = FVector2D(LeftUV, TopUV);
-			TextureCoordinates[1] = FVector2D(Right, TopUV);
-			TextureCoordinates[2] = FVector2D(LeftUV, BottomUV);
-			TextureCoordinates[3] = FVector2D(Right, BottomUV);
+			Renderer.PreviousPositions[IDIndices[Index]] = FVector3f(Position.Get(0, Index), Position.Get(1, Index), Position.Get(2, Index));
+			Renderer.PreviousAcquireTags[IDIndices[Index]] = IDTags[Index];
 		}
-		else
+	}
+}
+
+// Lerps the positions from the previous step by the particle IDs, allocated on the mem stack. Reads nothing but the arguments, so it runs on any thread
+static const float* InterpolateParticlePositions(const TArray<FVector3f>& PreviousPositions, const TArray<int32>& PreviousAcquireTags, const FNiagaraUIFloatStream& Position, const int32* IDIndices,
+												const int32* IDTags, int32 ParticleCount, float InterpolationAlpha)
+{
+	// Same layout as the particle buffer, one stream per component
+	float* InterpolatedPositions = new(FMemStack::Get()) float[ParticleCount * 3];
+
+	for (int32 Index = 0; Index < ParticleCount; ++Index)
+	{
+		const FVector3f Current(Position.Get(0, Index), Position.Get(1, Index), Position.Get(2, Index));
+		const int32 IDIndex = IDIndices[Index];
+
+		// Particles spawned by the last step have no previous position and are drawn where they are
+		const bool HasPrevious = PreviousAcquireTags.IsValidIndex(IDIndex) && PreviousAcquireTags[IDIndex] == IDTags[Index];
+		const FVector3f Interpolated = HasPrevious ? FMath::Lerp(PreviousPositions[IDIndex], Current, InterpolationAlpha) : Current;
+
+		InterpolatedPositions[Index] = Interpolated.X;
+		InterpolatedPositions[ParticleCount + Index] = Interpolated.Y;
+		InterpolatedPositions[ParticleCount * 2 + Index] = Interpolated.Z;
+	}
+
+	return InterpolatedPositions;
+}
+
+const float* UNiagaraUIComponent::InterpolatePositions(const FNiagaraUIRendererEntry& Renderer, const FNiagaraDataBuffer& ParticleData, const FNiagaraUIFloatAttribute& PositionAttribute, int32 ParticleCount) const
+{
+	if (InterpolationAlpha >= 1.f || Renderer.PreviousAcquireTags.Num() == 0 || !Renderer.ParticleID.IsBound() || !PositionAttribute.IsBound())
+		return nullptr;
+
+	const FNiagaraUIFloatStream Position(ParticleData, PositionAttribute, FNiagaraUIFloatStream::Zeros);
+	const int32* IDIndices = reinterpret_cast<const int32*>(ParticleData.GetComponentPtrInt32(Renderer.ParticleID.ComponentStart));
+	const int32* IDTags = reinterpret_cast<const int32*>(ParticleData.GetComponentPtrInt32(Renderer.ParticleID.ComponentStart + 1));
+
+	return InterpolateParticlePositions(Renderer.PreviousPositions, Renderer.PreviousAcquireTags, Position, IDIndices, IDTags, ParticleCount, InterpolationAlpha);
+}
+
+void UNiagaraUIComponent::RenderUI(SNiagaraUISystemWidget* NiagaraWidget, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UNiagaraUIComponent::RenderUI);
+
+	NiagaraWidget->ClearRenderData();
+
+	if (!IsActive())
+		return;
+
+	if (!GetSystemInstanceController())
+		return;
+
+	const FNiagaraSystemInstance* SystemInstance = GetSystemInstanceController()->GetSystemInstance_Unsafe();
+
+	if (!SystemInstance)
+		return;
+
+	UpdateRendererCache(*SystemInstance);
+
+	const auto& Emitters = SystemInstance->GetEmitters();
+	
+	for (const FNiagaraUIRendererEntry& Renderer : CachedRenderers)
+	{
+		const FNiagaraEmitterInstance& EmitterInst = Emitters[Renderer.EmitterIndex].Get();
+
+		if (!HasEmitterParticlesToRender(EmitterInst))
+			continue;
+
+		switch (Renderer.Type)
 		{
-			TextureCoordinates[0] = FVector2D(0.f, 0.f);
-			TextureCoordinates[1] = FVector2D(1.f, 0.f);
-			TextureCoordinates[2] = FVector2D(0.f, 1.f);
-			TextureCoordinates[3] = FVector2D(1.f, 1.f);
+		case FNiagaraUIRendererEntry::EType::Sprite:
+			AddSpriteRendererData(NiagaraWidget, EmitterInst, Renderer, RenderProperties, WidgetProperties);
+			break;
+			
+		case FNiagaraUIRendererEntry::EType::Ribbon:
+			AddRibbonRendererData(NiagaraWidget, EmitterInst, Renderer, RenderProperties, WidgetProperties);
+			break;
 		}
+	}
+}
 
-		
-		const FVector4f MaterialData = GetDynamicMaterialData(ParticleIndex);
+#if WITH_EDITOR
+void UNiagaraUIComponent::RecordBakedFrame(UNiagaraUIBakedEffect* BakedEffect, int32 FrameIndex)
+{
+	if (!BakedEffect || !GetSystemInstanceController())
+		return;
 
-		FVector2D PositionArray[4];
-		PositionArray[0] = FastRotate(FVector2D(-ParticleHalfSize.X, -ParticleHalfSize.Y), ParticleRotationSin, ParticleRotationCos);
-		PositionArray[1] = FastRotate(FVector2D(ParticleHalfSize.X, -ParticleHalfSize.Y), ParticleRotationSin, ParticleRotationCos);
-		PositionArray[2] = - PositionArray[1];
-		PositionArray[3] = - PositionArray[0];
-		
-		const int VertexIndex = ParticleIndex * 4;
-		const int indexIndex = ParticleIndex * 6;		
-		
+	const FNiagaraSystemInstance* SystemInstance = GetSystemInstanceController()->GetSystemInstance_Unsafe();
+
+	if (!SystemInstance)
+		return;
+
+	UpdateRendererCache(*SystemInstance);
+
+	const auto& Emitters = SystemInstance->GetEmitters();
+
+	// Every renderer gets a frame, even an empty one, so the frames stay aligned across renderers
+	for (int32 RendererIndex = 0; RendererIndex < CachedRenderers.Num(); ++RendererIndex)
+	{
+		const FNiagaraUIRendererEntry& Renderer = CachedRenderers[RendererIndex];
+
+		if (Renderer.Type != FNiagaraUIRendererEntry::EType::Sprite)
+			continue;
+
+		const UNiagaraSpriteRendererProperties* SpriteRenderer = Renderer.SpriteRenderer.Get();
+		const FNiagaraEmitterInstance& EmitterInst = Emitters[Renderer.EmitterIndex].Get();
+		const FVector2f SubImageSize = FVector2f(SpriteRenderer->SubImageSize);
+		const bool LocalSpace = IsEmitterLocalSpace(EmitterInst);
 		
-		for (int i = 0; i < 4; ++i)
+#if ENGINE_MINOR_VERSION < 4
+		FNiagaraDataSet& DataSet = EmitterInst.GetData();
+#else
+		const FNiagaraDataSet& DataSet = EmitterInst.GetParticleData();
+#endif
+
+		if (!HasEmitterParticlesToRender(EmitterInst) || !DataSet.IsCurrentDataValid())
 		{
-			VertexData[VertexIndex + i].Position = FVector2f(PositionArray[i]) + ParticlePosition;
-			VertexData[VertexIndex + i].Color = ParticleColor;
-			VertexData[VertexIndex + i].TexCoords[0] = TextureCoordinates[i].X;
-			VertexData[VertexIndex + i].TexCoords[1] = TextureCoordinates[i].Y;
-			VertexData[VertexIndex + i].TexCoords[2] = MaterialData.X;
-			VertexData[VertexIndex + i].TexCoords[3] = MaterialData.Y;
+			BakedEffect->AddSpriteFrame(FrameIndex, RendererIndex, SpriteRenderer->Material, SubImageSize, LocalSpace, FNiagaraUISpriteKernelParams(), 0);
+			continue;
 		}
+
+		FNiagaraDataBuffer& ParticleData = DataSet.GetCurrentDataChecked();
 		
+		FNiagaraUISpriteKernelParams Particles(ParticleData, Renderer.SpriteLayout);
+		Particles.Orientation = GetSpriteOrientation(SpriteRenderer, Particles);
 		
-		IndexData[indexIndex] = VertexIndex;
-		IndexData[indexIndex + 1] = VertexIndex + 1;
-		IndexData[indexIndex + 2] = VertexIndex + 2;
+		BakedEffect->AddSpriteFrame(FrameIndex, RendererIndex, SpriteRenderer->Material, SubImageSize, LocalSpace, Particles, ParticleData.GetNumInstances());
+	}
+}
+#endif
+
+const FName UNiagaraUIComponent::InstancedSpritesParameter(TEXT("NiagaraUIInstancedSprites"));
+
+bool UNiagaraUIComponent::IsInstancedSpriteMaterial(const UMaterialInterface* Material)
+{
+	float Enabled = 0.f;
+	
+	return Material && Material->GetScalarParameterValue(FMaterialParameterInfo(InstancedSpritesParameter), Enabled) && Enabled > 0.f;
+}
+
+// Builds the vertices of the sprites in the kernel streams. The caller sets the streams, the space and the orientation. InstancedMaterial tells if
+// the material expands instanced sprite records, it's resolved on the game thread
+static void AddSpriteVertices(SNiagaraUISystemWidget* NiagaraWidget, FNiagaraUISpriteKernelParams& KernelParams, UMaterialInterface* Material, bool InstancedMaterial, FVector2f SubImageSize, FVector SimulationLocation,
+								int32 ParticleCount, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties)
+{
+	KernelParams.FakeDepthScale = WidgetProperties->FakeDepthScale;
+	KernelParams.ScaleFactor = RenderProperties.ScaleFactor;
+	KernelParams.ParentTopLeft = RenderProperties.ParentTopLeft;
+	KernelParams.Tint = RenderProperties.Tint;
+	KernelParams.ComponentScale = RenderProperties.WidgetScale;
+	KernelParams.ComponentOffset = RenderProperties.WidgetLocation * RenderProperties.ScaleFactor;
+	KernelParams.WidgetRotationAngle = RenderProperties.WidgetAngle;
+	KernelParams.WorldSpaceOffset = (RenderProperties.WidgetLocation - FVector2f(SimulationLocation.X, -SimulationLocation.Z)) * RenderProperties.ScaleFactor;
+	KernelParams.FakeDepthScaleDistance = WidgetProperties->FakeDepthScaleDistance;
+	KernelParams.SubImageSize = SubImageSize;
+	KernelParams.MinScreenSize = FMath::Max(WidgetProperties->MinParticleScreenSize, NiagaraUICVars::MinParticleScreenSize);
+	KernelParams.ThinSubPixelParticles = WidgetProperties->ThinSubPixelParticles;
+	KernelParams.KeepFraction = RenderProperties.ParticleFraction;
+
+	// Instanced sprites upload one packed record per particle, the material expands them into quads around the widget's center. Any other material
+	// would draw all of them as a single point at the center, so those sprites are generated as vertices
+	if (WidgetProperties->UseInstancedSprites && NiagaraUICVars::InstancedSprites != 0
+		&& ensureMsgf(InstancedMaterial, TEXT("Use Instanced Sprites needs a material made by Create Instanced Niagara UI Material, %s is drawn with vertices instead."), *GetNameSafe(Material)))
+	{
+		const FVector2f Origin = RenderProperties.ParentTopLeft + RenderProperties.WidgetLocation * RenderProperties.ScaleFactor;
+		FVector4f* InstanceData;
 		
-		IndexData[indexIndex + 3] = VertexIndex + 2;
-		IndexData[indexIndex + 4] = VertexIndex + 1;
-		IndexData[indexIndex + 5] = VertexIndex + 3;
+		NiagaraWidget->AddInstancedRenderData(&InstanceData, Material, ParticleCount, Origin, SubImageSize);
+
+		const int32 NumInstances = NiagaraUISpriteKernels::BuildSpriteInstances(KernelParams, InstanceData, ParticleCount, Origin, RenderProperties.CullingRect);
+
+		if (NumInstances != INDEX_NONE)
+		{
+			if (NumInstances < ParticleCount)
+				NiagaraWidget->TrimInstanceData(NumInstances);
+
+			INC_DWORD_STAT_BY(STAT_NiagaraUIEmittedSprites, NumInstances);
+			INC_DWORD_STAT_BY(STAT_NiagaraUIInstancedSprites, NumInstances);
+			INC_DWORD_STAT_BY(STAT_NiagaraUICulledSprites, ParticleCount - NumInstances);
+			return;
+		}
+
+		// Sprites the records can't hold are generated as vertices instead
+		NiagaraWidget->TrimInstanceData(0);
 	}
+
+	FSlateVertex* VertexData;	
+	SlateIndex* IndexData;
+
+	NiagaraWidget->AddRenderData(&VertexData, &IndexData, Material, ParticleCount * FNiagaraUISpriteIndexBuffer::VerticesPerSprite, ParticleCount * FNiagaraUISpriteIndexBuffer::IndicesPerSprite, true);
+	KernelParams.VertexData = VertexData;
+
+	const int32 NumVisibleSprites = NiagaraUISpriteKernels::BuildSprites(KernelParams, IndexData, ParticleCount, RenderProperties.CullingRect);
+
+	if (NumVisibleSprites < ParticleCount)
+		NiagaraWidget->TrimRenderData(NumVisibleSprites * FNiagaraUISpriteIndexBuffer::VerticesPerSprite, NumVisibleSprites * FNiagaraUISpriteIndexBuffer::IndicesPerSprite);
+
+	INC_DWORD_STAT_BY(STAT_NiagaraUIEmittedSprites, NumVisibleSprites);
+	INC_DWORD_STAT_BY(STAT_NiagaraUICulledSprites, ParticleCount - NumVisibleSprites);
 }
 
-void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraWidget, TSharedRef<const FNiagaraEmitterInstance> EmitterInst, UNiagaraRibbonRendererProperties* RibbonRenderer, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties)
+void UNiagaraUIComponent::AddSpriteRendererData(SNiagaraUISystemWidget* NiagaraWidget, const FNiagaraEmitterInstance& EmitterInst, const FNiagaraUIRendererEntry& Renderer, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties)
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(UNiagaraUIComponent::AddRibbonRendererData);
-	SCOPE_CYCLE_COUNTER(STAT_GenerateRibbonData);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UNiagaraUIComponent::AddSpriteRendererData);
+	SCOPE_CYCLE_COUNTER(STAT_GenerateSpriteData);
 	
-	FVector ComponentLocation = GetRelativeLocation();
-	FVector ComponentScale = GetRelativeScale3D();
+	const UNiagaraSpriteRendererProperties* SpriteRenderer = Renderer.SpriteRenderer.Get();
 
 #if ENGINE_MINOR_VERSION < 4
-	FNiagaraDataSet& DataSet = EmitterInst->GetData();
+	FNiagaraDataSet& DataSet = EmitterInst.GetData();
 #else
-	const FNiagaraDataSet& DataSet = EmitterInst->GetParticleData();
+	const FNiagaraDataSet& DataSet = EmitterInst.GetParticleData();
 #endif
 			
 	
@@ -417,90 +734,314 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 		return;
 	
 	FNiagaraDataBuffer& ParticleData = DataSet.GetCurrentDataChecked();
-	const int32 ParticleCount = ParticleData.GetNumInstances();
+	const int32 NumInstances = ParticleData.GetNumInstances();
 
-	if (ParticleCount < 2)
+	if (NumInstances < 1)
 		return;
-			
-	const float& ScaleFactor = RenderProperties.ScaleFactor;
-	const FVector2f& ParentTopLeft = RenderProperties.ParentTopLeft;
-	const FLinearColor& Tint = RenderProperties.Tint;
+
+	FNiagaraUISpriteKernelParams KernelParams(ParticleData, Renderer.SpriteLayout);
+	KernelParams.LocalSpace = IsEmitterLocalSpace(EmitterInst);
+	KernelParams.Orientation = GetSpriteOrientation(SpriteRenderer, KernelParams);
+
+	if (Renderer.ParticleID.IsBound())
+	{
+		KernelParams.IDIndex = reinterpret_cast<const int32*>(ParticleData.GetComponentPtrInt32(Renderer.ParticleID.ComponentStart));
+		KernelParams.IDAcquireTag = reinterpret_cast<const int32*>(ParticleData.GetComponentPtrInt32(Renderer.ParticleID.ComponentStart + 1));
+	}
+
+	FMemMark Mark(FMemStack::Get());
+
+	if (const float* InterpolatedPositions = InterpolatePositions(Renderer, ParticleData, Renderer.SpriteLayout.Position, NumInstances))
+		KernelParams.Position = FNiagaraUIFloatStream(InterpolatedPositions, NumInstances, FNiagaraUIFloatStream::Zeros);
+
+	const int32 ParticleCount = NiagaraUISpriteKernels::CapParticles(KernelParams, NumInstances, NiagaraUICVars::MaxParticlesPerRenderer);
+
+	if (ParticleCount < 1)
+		return;
+
+	const bool InstancedMaterial = WidgetProperties->UseInstancedSprites && IsInstancedSpriteMaterial(SpriteRenderer->Material);
 	
+	AddSpriteVertices(NiagaraWidget, KernelParams, SpriteRenderer->Material, InstancedMaterial, FVector2f(SpriteRenderer->SubImageSize), GetRelativeLocation(), ParticleCount, RenderProperties, WidgetProperties);
+}
+
+static FNiagaraUIRibbonUVSettings GetRibbonUVSettings(const UNiagaraRibbonRendererProperties* RibbonRenderer)
+{
+	FNiagaraUIRibbonUVSettings UVSettings;
+	UVSettings.TiledU0 = RibbonRenderer->UV0Settings.DistributionMode == ENiagaraRibbonUVDistributionMode::TiledOverRibbonLength;
+	UVSettings.U0TilingLength = RibbonRenderer->UV0Settings.TilingLength;
+	UVSettings.TiledU1 = RibbonRenderer->UV1Settings.DistributionMode == ENiagaraRibbonUVDistributionMode::TiledOverRibbonLength;
+	UVSettings.U1TilingLength = RibbonRenderer->UV1Settings.TilingLength;
+
+	return UVSettings;
+}
+
+// Copies the link order and ribbon IDs the ribbons are gathered by. Fails if the emitter doesn't write the link order
+template<typename DataSetType>
+static bool ReadRibbonLinkData(DataSetType& DataSet, const UNiagaraRibbonRendererProperties* RibbonRenderer, int32 ParticleCount, FNiagaraUIRibbonLinkData& OutLinkData)
+{
+	OutLinkData.LinkOrderFloat.Reset();
+	OutLinkData.LinkOrderInt32.Reset();
+	OutLinkData.RibbonIDs.Reset();
+
 #if ENGINE_MINOR_VERSION < 3
 	const auto SortKeyReader = RibbonRenderer->SortKeyDataSetAccessor.GetReader(DataSet);
 
 	if (!ensureMsgf(SortKeyReader.IsValid(), TEXT("Invalid Sort Key Reader encrountered while rendering ribbon particles. This can happen if the particle is missing \"Particle State\" module.")))
 	{
-		return;
+		return false;
 	}
-			
-	auto RibbonLinkOrderSort = [&SortKeyReader](TArray<int32>& Container)
-	{
-		Container.Sort([&SortKeyReader](const int32& A, const int32& B) {	return (SortKeyReader[A] < SortKeyReader[B]); });
-	};
+
+	OutLinkData.LinkOrderFloat.SetNumUninitialized(ParticleCount);
+
+	for (int32 i = 0; i < ParticleCount; ++i)
+		OutLinkData.LinkOrderFloat[i] = SortKeyReader[i];
 #else
 	const auto RibbonLinkOrderFloatData = RibbonRenderer->RibbonLinkOrderFloatAccessor.GetReader(DataSet);
 	const auto RibbonLinkOrderInt32Data = RibbonRenderer->RibbonLinkOrderInt32Accessor.GetReader(DataSet);
 			
 	if (!ensureMsgf(RibbonLinkOrderFloatData.IsValid() || RibbonLinkOrderInt32Data.IsValid(), TEXT("Invalid Sort Key Reader encrountered while rendering ribbon particles. This can happen if the particle is missing \"Particle State\" module.")))
 	{
-		return;
+		return false;
+	}
+
+	if (RibbonLinkOrderFloatData.IsValid())
+	{
+		OutLinkData.LinkOrderFloat.SetNumUninitialized(ParticleCount);
+
+		for (int32 i = 0; i < ParticleCount; ++i)
+			OutLinkData.LinkOrderFloat[i] = RibbonLinkOrderFloatData[i];
+	}
+	else
+	{
+		OutLinkData.LinkOrderInt32.SetNumUninitialized(ParticleCount);
+
+		for (int32 i = 0; i < ParticleCount; ++i)
+			OutLinkData.LinkOrderInt32[i] = RibbonLinkOrderInt32Data[i];
+	}
+#endif
+
+	const auto RibbonFullIDData = RibbonRenderer->RibbonFullIDDataSetAccessor.GetReader(DataSet);
+
+	if (RibbonFullIDData.IsValid())
+	{
+		OutLinkData.RibbonIDs.SetNumUninitialized(ParticleCount);
+
+		for (int32 i = 0; i < ParticleCount; ++i)
+			OutLinkData.RibbonIDs[i] = RibbonFullIDData[i];
 	}
 
-	auto RibbonLinkOrderSort = [&RibbonLinkOrderFloatData, &RibbonLinkOrderInt32Data](TArray<int32>& Container)
+	return true;
+}
+
+// Splits the particles into ribbons sorted by their link order. Ribbon indices are concatenated, with the end of each ribbon in OutRibbonEnds
+// and a key hashed from its ribbon ID in OutRibbonKeys. Reads nothing but the link data, so it runs on any thread
+static void GatherRibbons(const FNiagaraUIRibbonLinkData& LinkData, int32 ParticleCount, TArray<int32>& OutRibbonIndices, TArray<int32>& OutRibbonEnds, TArray<uint32>& OutRibbonKeys)
+{
+	auto RibbonLinkOrderSort = [&LinkData](TArray<int32>& Container)
 	{
-		if (RibbonLinkOrderFloatData.IsValid())
+		if (LinkData.LinkOrderFloat.Num() > 0)
 		{
-			Container.Sort([&RibbonLinkOrderFloatData](const uint32& A, const uint32& B) { return RibbonLinkOrderFloatData[A] < RibbonLinkOrderFloatData[B]; });
+			Container.Sort([&LinkData](const int32& A, const int32& B) { return LinkData.LinkOrderFloat[A] < LinkData.LinkOrderFloat[B]; });
 		}
 		else
 		{
-			Container.Sort([&RibbonLinkOrderInt32Data](const uint32& A, const uint32& B) { return RibbonLinkOrderInt32Data[A] > RibbonLinkOrderInt32Data[B]; });
+			Container.Sort([&LinkData](const int32& A, const int32& B) { return LinkData.LinkOrderInt32[A] > LinkData.LinkOrderInt32[B]; });
 		}
 	};
-#endif
 
-	const auto PositionData		= RibbonRenderer->PositionDataSetAccessor.GetReader(DataSet);
-	const auto ColorData		= FNiagaraDataSetAccessor<FLinearColor>::CreateReader(DataSet, RibbonRenderer->ColorBinding.GetDataSetBindableVariable().GetName());
-	const auto RibbonWidthData	= RibbonRenderer->SizeDataSetAccessor.GetReader(DataSet);
-	const auto DynamicMaterialData = FNiagaraDataSetAccessor<FVector4f>::CreateReader(DataSet, RibbonRenderer->DynamicMaterialBinding.GetDataSetBindableVariable().GetName());
-	
-	const auto RibbonFullIDData = RibbonRenderer->RibbonFullIDDataSetAccessor.GetReader(DataSet);
+	OutRibbonIndices.Reset(ParticleCount);
+	OutRibbonEnds.Reset();
+	OutRibbonKeys.Reset();
+
+	if (LinkData.RibbonIDs.Num() == 0)
+	{
+		for (int32 i = 0; i < ParticleCount; ++i)
+		{
+			OutRibbonIndices.Add(i);
+		}
+
+		RibbonLinkOrderSort(OutRibbonIndices);
+		OutRibbonEnds.Add(OutRibbonIndices.Num());
+		OutRibbonKeys.Add(0);
+
+		return;
+	}
+
+	TMap<FNiagaraID, TArray<int32>> MultiRibbonSortedIndices;
+
+	for (int32 i = 0; i < ParticleCount; ++i)
+	{
+		TArray<int32>& Indices = MultiRibbonSortedIndices.FindOrAdd(LinkData.RibbonIDs[i]);
+		Indices.Add(i);
+	}
+
+	// Sort the ribbons by ID so that the draw order stays consistent.
+	MultiRibbonSortedIndices.KeySort(TLess<FNiagaraID>());
+
+	for (TPair<FNiagaraID, TArray<int32>>& Pair : MultiRibbonSortedIndices)
+	{
+		TArray<int32>& SortedIndices = Pair.Value;
+		RibbonLinkOrderSort(SortedIndices);
+		
+		OutRibbonIndices.Append(SortedIndices);
+		OutRibbonEnds.Add(OutRibbonIndices.Num());
+		OutRibbonKeys.Add((uint32)Pair.Key.Index * 0x85ebca77u + (uint32)Pair.Key.AcquireTag);
+	}
+}
+
+// Builds the vertices of the gathered ribbons. Reads nothing but the given streams, so it's shared by the simulation and the snapshots
+static void AddRibbonVertices(SNiagaraUISystemWidget* NiagaraWidget, UMaterialInterface* Material, const FNiagaraUIRibbonUVSettings& UVSettings, const FNiagaraUIFloatStream& PositionData, const FNiagaraUIFloatStream& ColorData,
+								const FNiagaraUIFloatStream& RibbonWidthData, const FNiagaraUIFloatStream& DynamicMaterialData, bool LocalSpace, FVector SimulationLocation, const TArray<int32>& GatheredIndices, const TArray<int32>& RibbonEnds,
+								const TArray<uint32>& RibbonKeys, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties)
+{
+	const float& ScaleFactor = RenderProperties.ScaleFactor;
+	const FVector2f& ParentTopLeft = RenderProperties.ParentTopLeft;
+	const FLinearColor& Tint = RenderProperties.Tint;
+	const FSlateRect& CullingRect = RenderProperties.CullingRect;
+	const FVector2f& WidgetScale = RenderProperties.WidgetScale;
+	const float WidgetAngle = RenderProperties.WidgetAngle;
+	const FVector2f WidgetOffset = RenderProperties.WidgetLocation * RenderProperties.ScaleFactor;
+	const FVector2f WorldSpaceOffset = WidgetOffset - FVector2f(SimulationLocation.X, -SimulationLocation.Z) * RenderProperties.ScaleFactor;
+	const bool CullSegments = CullingRect.IsValid();
 
 	auto GetParticlePosition2D = [&PositionData](int32 Index)
 	{
-		const FVector3f Position3D = PositionData.GetSafe(Index, FVector3f::ZeroVector);
-		return FVector2f(Position3D.X, -Position3D.Z);
+		return FVector2f(PositionData.Get(0, Index), -PositionData.Get(2, Index));
 	};	
 
-	auto GetParticleColor = [&ColorData, &Tint](int32 Index)
+	// Tint is applied as part of the sRGB conversion
+	auto GetParticleColor = [&ColorData, &Tint](int32 Index, float AlphaScale)
 	{
-		return ColorData.GetSafe(Index, FLinearColor::White) * Tint;
+		FLinearColor ParticleTint = Tint;
+		ParticleTint.A *= AlphaScale;
+		
+		return FNiagaraUIColorConversion::ToFColorSRGB(ColorData.GetColor(Index), ParticleTint);
 	};
 	
 	auto GetParticleWidth = [&RibbonWidthData](int32 Index)
 	{
-		return RibbonWidthData.GetSafe(Index, 1.f);
+		return RibbonWidthData.Get(0, Index);
+	};
+
+	// Segments thinner than the minimum screen size are widened to it, with their alpha scaled down to keep the same coverage. Ribbons surviving
+	// the sub-pixel thinning are scaled up by RibbonAlphaScale, so the expected coverage of all of them stays the same too
+	const float MinScreenSize = FMath::Max(WidgetProperties->MinParticleScreenSize, NiagaraUICVars::MinParticleScreenSize);
+	float RibbonAlphaScale = 1.f;
+	
+	auto ApplyMinScreenSize = [MinScreenSize, &RibbonAlphaScale](float& Width, float& AlphaScale)
+	{
+		AlphaScale = 1.f;
+		
+		if (MinScreenSize <= 0.f || FMath::Abs(Width) >= MinScreenSize)
+			return;
+
+		AlphaScale = FMath::Min(FMath::Abs(Width) / MinScreenSize * RibbonAlphaScale, 1.f);
+		Width = Width < 0.f ? -MinScreenSize : MinScreenSize;
+	};
+
+	// Sub-pixel ribbons are treated like sub-pixel sprites. The whole ribbon is kept with a probability of its coverage, hashed from its ID so
+	// the same ribbons stay, or dropped by the Drop mode. Sub-pixel segments shorter than the minimum size are merged into the next one
+	const float MinSegmentLengthSquared = FMath::Square(MinScreenSize / FMath::Max(ScaleFactor, 1e-4f));
+
+	auto ThinSubPixelRibbon = [&](TArray<int32>& RibbonIndices, uint32 RibbonKey)
+	{
+		RibbonAlphaScale = 1.f;
+
+		if (MinScreenSize <= 0.f)
+			return true;
+
+		auto IsSubPixel = [&](int32 Index)
+		{
+			return FMath::Abs(GetParticleWidth(Index)) * ScaleFactor < MinScreenSize;
+		};
+
+		float MaxWidth = 0.f;
+
+		for (const int32 Index : RibbonIndices)
+			MaxWidth = FMath::Max(MaxWidth, FMath::Abs(GetParticleWidth(Index)) * ScaleFactor);
+
+		if (MaxWidth < MinScreenSize)
+		{
+			const float Coverage = MaxWidth / MinScreenSize;
+
+			if (!WidgetProperties->ThinSubPixelParticles || NiagaraUISpriteKernels::HashParticleIndex(RibbonKey) >= Coverage)
+				return false;
+
+			RibbonAlphaScale = 1.f / Coverage;
+		}
+
+		if (RibbonIndices.Num() > 2)
+		{
+			int32 NumKept = 1;
+
+			for (int32 i = 1; i < RibbonIndices.Num() - 1; ++i)
+			{
+				const int32 Index = RibbonIndices[i];
+
+				if (!IsSubPixel(Index) || (GetParticlePosition2D(Index) - GetParticlePosition2D(RibbonIndices[NumKept - 1])).SizeSquared() >= MinSegmentLengthSquared)
+					RibbonIndices[NumKept++] = Index;
+			}
+
+			RibbonIndices[NumKept++] = RibbonIndices.Last();
+			RibbonIndices.SetNum(NumKept);
+		}
+
+		return true;
 	};
 	
 	auto GetDynamicMaterialData = [&DynamicMaterialData](int32 Index)
 	{
-		return DynamicMaterialData.GetSafe(Index, FVector4f(0.f, 0.f, 0.f, 0.f));
+		return DynamicMaterialData.GetVector4(Index);
 	};
 
-#if ENGINE_MINOR_VERSION < 1		
-	bool LocalSpace = EmitterInst->GetCachedEmitter()->bLocalSpace;
-#elif ENGINE_MINOR_VERSION < 4
-	bool LocalSpace = EmitterInst->GetCachedEmitterData()->bLocalSpace;
-#else
-	bool LocalSpace = EmitterInst->GetVersionedEmitter().GetEmitterData()->bLocalSpace;
-#endif
-			
-	const bool FullIDs = RibbonFullIDData.IsValid();
-	const bool MultiRibbons = FullIDs;
+	// Tolerance is converted from pixels to simulation units, ignoring the component scale
+	const float DecimationTolerance = NiagaraUICVars::RibbonDecimationTolerance / FMath::Max(ScaleFactor, 1e-4f);
+	const int32 MaxRibbonParticles = NiagaraUICVars::MaxParticlesPerRenderer;
+
+	auto DecimateRibbon = [&](TArray<int32>& RibbonIndices)
+	{
+		// Greedily skips particles lying close to the line between the last kept particle and the next one
+		if (DecimationTolerance > 0.f && RibbonIndices.Num() > 2)
+		{
+			const float ToleranceSquared = FMath::Square(DecimationTolerance);
+			int32 NumKept = 1;
+
+			for (int32 i = 1; i < RibbonIndices.Num() - 1; ++i)
+			{
+				const FVector2f Previous = GetParticlePosition2D(RibbonIndices[NumKept - 1]);
+				const FVector2f Current = GetParticlePosition2D(RibbonIndices[i]);
+				const FVector2f Segment = GetParticlePosition2D(RibbonIndices[i + 1]) - Previous;
+
+				const float SegmentSizeSquared = Segment.SizeSquared();
+				const float T = SegmentSizeSquared > 1e-8f ? FMath::Clamp(FVector2f::DotProduct(Current - Previous, Segment) / SegmentSizeSquared, 0.f, 1.f) : 0.f;
 
-	auto AddRibbonVerts = [&](TArray<int32>& RibbonIndices)
+				if ((Previous + Segment * T - Current).SizeSquared() > ToleranceSquared)
+					RibbonIndices[NumKept++] = RibbonIndices[i];
+			}
+
+			RibbonIndices[NumKept++] = RibbonIndices.Last();
+			RibbonIndices.SetNum(NumKept);
+		}
+
+		// Uniform subsampling keeps both ends of the ribbon
+		if (MaxRibbonParticles > 1 && RibbonIndices.Num() > MaxRibbonParticles)
+		{
+			const int32 LastIndex = RibbonIndices.Num() - 1;
+
+			for (int32 i = 0; i < MaxRibbonParticles; ++i)
+				RibbonIndices[i] = RibbonIndices[(int32)((int64)i * LastIndex / (MaxRibbonParticles - 1))];
+
+			RibbonIndices.SetNum(MaxRibbonParticles);
+		}
+	};
+
+	auto AddRibbonVerts = [&](TArray<int32>& RibbonIndices, uint32 RibbonKey)
 	{
+		if (!ThinSubPixelRibbon(RibbonIndices, RibbonKey))
+			return;
+
+		DecimateRibbon(RibbonIndices);
+		
 		const int32 NumParticlesInRibbon = RibbonIndices.Num();
 		if (NumParticlesInRibbon < 2)
 			return;
@@ -508,13 +1049,11 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 		FSlateVertex* VertexData;	
 		SlateIndex* IndexData;
 	
-		FSlateBrush Brush;
-		UMaterialInterface* SpriteMaterial = RibbonRenderer->Material;
-		
-		NiagaraWidget->AddRenderData(&VertexData, &IndexData, SpriteMaterial, (NumParticlesInRibbon) * 2, (NumParticlesInRibbon - 1) * 6);
+		NiagaraWidget->AddRenderData(&VertexData, &IndexData, Material, (NumParticlesInRibbon) * 2, (NumParticlesInRibbon - 1) * 6);
 
 		int32 CurrentVertexIndex = 0;
 		int32 CurrentIndexIndex = 0;
+		int32 NumCulledSegments = 0;
 		
 			
 		const int32 StartDataIndex = RibbonIndices[0];
@@ -533,15 +1072,15 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 		
 		if (LocalSpace)
 		{
-			LastParticleUIPosition *= FVector2f(ComponentScale.X, ComponentScale.Z);
-			LastParticleUIPosition = LastParticleUIPosition.GetRotated(-WidgetRotationAngle);
+			LastParticleUIPosition *= WidgetScale;
+			LastParticleUIPosition = LastParticleUIPosition.GetRotated(-WidgetAngle);
 			LastParticleUIPosition += ParentTopLeft;
 			
-			LastParticleUIPosition += FVector2f(ComponentLocation.X, -ComponentLocation.Z) * ScaleFactor;
+			LastParticleUIPosition += WidgetOffset;
 		}
 		else
 		{
-			LastParticleUIPosition += ParentTopLeft;
+			LastParticleUIPosition += ParentTopLeft + WorldSpaceOffset;
 		}
 		
 		int32 CurrentIndex = 1;
@@ -555,8 +1094,11 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 		LastToCurrentVector *= 1.f / LastToCurrentSize;
 		
 
-		const FColor InitialColor = GetParticleColor(StartDataIndex).ToFColor(true);
-		const float InitialWidth = GetParticleWidth(StartDataIndex) * ScaleFactor;
+		float InitialWidth = GetParticleWidth(StartDataIndex) * ScaleFactor;
+		float InitialAlphaScale;
+		ApplyMinScreenSize(InitialWidth, InitialAlphaScale);
+		
+		const FColor InitialColor = GetParticleColor(StartDataIndex, InitialAlphaScale);
 		
 		FVector2f InitialPositionArray[2];
 		InitialPositionArray[0] = LastToCurrentVector.GetRotated(90.f) * InitialWidth * 0.5f;
@@ -584,7 +1126,10 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 			
 			const float CurrentToNextSize = CurrentToNextVector.Size();		
 			CurrentWidth = GetParticleWidth(CurrentDataIndex) * ScaleFactor;
-			FColor CurrentColor = GetParticleColor(CurrentDataIndex).ToFColor(true);
+			float CurrentAlphaScale;
+			ApplyMinScreenSize(CurrentWidth, CurrentAlphaScale);
+			
+			FColor CurrentColor = GetParticleColor(CurrentDataIndex, CurrentAlphaScale);
 
 			// Normalize CurrToNextVec
 			CurrentToNextVector *= 1.f / CurrentToNextSize;
@@ -601,21 +1146,21 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 
 			if (LocalSpace)
 			{
-				CurrentParticleUIPosition *= FVector2f(ComponentScale.X, ComponentScale.Z);
-				CurrentParticleUIPosition = CurrentParticleUIPosition.GetRotated(-WidgetRotationAngle);
+				CurrentParticleUIPosition *= WidgetScale;
+				CurrentParticleUIPosition = CurrentParticleUIPosition.GetRotated(-WidgetAngle);
 				CurrentParticleUIPosition += ParentTopLeft;
-				CurrentParticleUIPosition += FVector2f(ComponentLocation.X, -ComponentLocation.Z) * ScaleFactor;
+				CurrentParticleUIPosition += WidgetOffset;
 			}
 			else
 			{
-				CurrentParticleUIPosition += ParentTopLeft;
+				CurrentParticleUIPosition += ParentTopLeft + WorldSpaceOffset;
 			}
 
 			float CurrentU0 = 0.f;
 		
-			if (RibbonRenderer->UV0Settings.DistributionMode == ENiagaraRibbonUVDistributionMode::TiledOverRibbonLength)
+			if (UVSettings.TiledU0)
 			{
-				CurrentU0 = LastU0 + LastToCurrentSize / RibbonRenderer->UV0Settings.TilingLength;
+				CurrentU0 = LastU0 + LastToCurrentSize / UVSettings.U0TilingLength;
 			}
 			else
 			{
@@ -640,9 +1185,9 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 			{
 				float CurrentU1 = 0.f;
 				
-				if (RibbonRenderer->UV1Settings.DistributionMode == ENiagaraRibbonUVDistributionMode::TiledOverRibbonLength)
+				if (UVSettings.TiledU1)
 				{
-					CurrentU1 = LastU1 + LastToCurrentSize / RibbonRenderer->UV1Settings.TilingLength;
+					CurrentU1 = LastU1 + LastToCurrentSize / UVSettings.U1TilingLength;
 				}
 				else
 				{
@@ -665,17 +1210,25 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 				VertexData[CurrentVertexIndex + i].TexCoords[3] = TextureCoordinates1[i].Y;
 			}
 			
-			IndexData[CurrentIndexIndex] = CurrentVertexIndex - 2;
-			IndexData[CurrentIndexIndex + 1] = CurrentVertexIndex - 1;
-			IndexData[CurrentIndexIndex + 2] = CurrentVertexIndex;
-		
-			IndexData[CurrentIndexIndex + 3] = CurrentVertexIndex - 1;
-			IndexData[CurrentIndexIndex + 4] = CurrentVertexIndex;
-			IndexData[CurrentIndexIndex + 5] = CurrentVertexIndex + 1;
+			// Segments outside of the culling rect keep their vertices, so the neighbouring segments stay connected, but aren't indexed
+			if (CullSegments && NiagaraUICulling::IsQuadOutside(&VertexData[CurrentVertexIndex - 2], CullingRect))
+			{
+				++NumCulledSegments;
+			}
+			else
+			{
+				IndexData[CurrentIndexIndex] = CurrentVertexIndex - 2;
+				IndexData[CurrentIndexIndex + 1] = CurrentVertexIndex - 1;
+				IndexData[CurrentIndexIndex + 2] = CurrentVertexIndex;
 			
+				IndexData[CurrentIndexIndex + 3] = CurrentVertexIndex - 1;
+				IndexData[CurrentIndexIndex + 4] = CurrentVertexIndex;
+				IndexData[CurrentIndexIndex + 5] = CurrentVertexIndex + 1;
+				
+				CurrentIndexIndex += 6;
+			}
 
 			CurrentVertexIndex += 2;
-			CurrentIndexIndex += 6;
 			
 			CurrentIndex = NextIndex;
 			CurrentDataIndex = NextDataIndex;
@@ -688,44 +1241,282 @@ void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraW
 
 			++NextIndex;
 		}
+
+		if (NumCulledSegments > 0)
+			NiagaraWidget->TrimRenderData(CurrentVertexIndex, CurrentIndexIndex);
+
+		INC_DWORD_STAT_BY(STAT_NiagaraUIEmittedRibbonSegments, NumParticlesInRibbon - 1 - NumCulledSegments);
+		INC_DWORD_STAT_BY(STAT_NiagaraUICulledRibbonSegments, NumCulledSegments);
 	};
 
-	if (!MultiRibbons)
+	TArray<int32> RibbonIndices;
+	int32 RibbonStart = 0;
+
+	for (int32 RibbonIndex = 0; RibbonIndex < RibbonEnds.Num(); ++RibbonIndex)
 	{
-		TArray<int32> SortedIndices;
-		for (int32 i = 0; i < ParticleCount; ++i)
-		{
-			SortedIndices.Add(i);
-		}
+		const int32 RibbonEnd = RibbonEnds[RibbonIndex];
+		
+		RibbonIndices.Reset();
+		RibbonIndices.Append(GatheredIndices.GetData() + RibbonStart, RibbonEnd - RibbonStart);
+		RibbonStart = RibbonEnd;
 
-		RibbonLinkOrderSort(SortedIndices);
+		AddRibbonVerts(RibbonIndices, RibbonKeys[RibbonIndex]);
+	}
+}
+
+void UNiagaraUIComponent::AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraWidget, const FNiagaraEmitterInstance& EmitterInst, const FNiagaraUIRendererEntry& Renderer, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UNiagaraUIComponent::AddRibbonRendererData);
+	SCOPE_CYCLE_COUNTER(STAT_GenerateRibbonData);
+
+	const UNiagaraRibbonRendererProperties* RibbonRenderer = Renderer.RibbonRenderer.Get();
+
+#if ENGINE_MINOR_VERSION < 4
+	FNiagaraDataSet& DataSet = EmitterInst.GetData();
+#else
+	const FNiagaraDataSet& DataSet = EmitterInst.GetParticleData();
+#endif
+	
+	if (!DataSet.IsCurrentDataValid())
+		return;
+	
+	FNiagaraDataBuffer& ParticleData = DataSet.GetCurrentDataChecked();
+	const int32 ParticleCount = ParticleData.GetNumInstances();
+
+	if (ParticleCount < 2)
+		return;
+
+	FNiagaraUIRibbonLinkData LinkData;
+
+	if (!ReadRibbonLinkData(DataSet, RibbonRenderer, ParticleCount, LinkData))
+		return;
+
+	TArray<int32> RibbonIndices;
+	TArray<int32> RibbonEnds;
+	TArray<uint32> RibbonKeys;
+	GatherRibbons(LinkData, ParticleCount, RibbonIndices, RibbonEnds, RibbonKeys);
+
+	const FNiagaraUIRibbonLayout& Layout = Renderer.RibbonLayout;
+
+	FMemMark Mark(FMemStack::Get());
+	const float* InterpolatedPositions = InterpolatePositions(Renderer, ParticleData, Layout.Position, ParticleCount);
+	
+	const FNiagaraUIFloatStream PositionData		= InterpolatedPositions ? FNiagaraUIFloatStream(InterpolatedPositions, ParticleCount, FNiagaraUIFloatStream::Zeros) : FNiagaraUIFloatStream(ParticleData, Layout.Position, FNiagaraUIFloatStream::Zeros);
+	const FNiagaraUIFloatStream ColorData			(ParticleData, Layout.Color,			FNiagaraUIFloatStream::Ones);
+	const FNiagaraUIFloatStream RibbonWidthData		(ParticleData, Layout.Width,			FNiagaraUIFloatStream::Ones);
+	const FNiagaraUIFloatStream DynamicMaterialData	(ParticleData, Layout.DynamicMaterial,	FNiagaraUIFloatStream::Zeros);
+
+	AddRibbonVertices(NiagaraWidget, RibbonRenderer->Material, GetRibbonUVSettings(RibbonRenderer), PositionData, ColorData, RibbonWidthData, DynamicMaterialData, IsEmitterLocalSpace(EmitterInst), GetRelativeLocation(),
+						RibbonIndices, RibbonEnds, RibbonKeys, RenderProperties, WidgetProperties);
+}
+
+// Appends the components of a bound stream to the snapshot data. Returns the offset of the first component
+static int32 CopySnapshotStream(FNiagaraUISnapshotRenderer& Renderer, const FNiagaraUIFloatStream& Stream, int32 NumComponents)
+{
+	if (!Stream.IsBound())
+		return INDEX_NONE;
 
-		AddRibbonVerts(SortedIndices);
+	const int32 NumParticles = Renderer.NumParticles;
+	const int32 Offset = Renderer.Data.AddUninitialized(NumComponents * NumParticles);
+
+	for (int32 Component = 0; Component < NumComponents; ++Component)
+		FMemory::Memcpy(Renderer.Data.GetData() + Offset + Component * NumParticles, Stream.GetComponentData(Component), NumParticles * sizeof(float));
+
+	return Offset;
+}
+
+static FNiagaraUIFloatStream GetSnapshotStream(const FNiagaraUISnapshotRenderer& Renderer, int32 Offset, const float* DefaultValue)
+{
+	return FNiagaraUIFloatStream(Offset != INDEX_NONE ? Renderer.Data.GetData() + Offset : nullptr, Renderer.NumParticles, DefaultValue);
+}
+
+// Copies the ID streams and, while a reduced rate simulation is between two steps, the previous positions the worker interpolates from
+static void CopySnapshotIDs(FNiagaraUISnapshotRenderer& SnapshotRenderer, const FNiagaraUIRendererEntry& Renderer, const FNiagaraDataBuffer& ParticleData, float InterpolationAlpha)
+{
+	if (!Renderer.ParticleID.IsBound())
+		return;
+
+	const int32 NumParticles = SnapshotRenderer.NumParticles;
+	SnapshotRenderer.ParticleIDs.SetNumUninitialized(NumParticles * 2);
+	FMemory::Memcpy(SnapshotRenderer.ParticleIDs.GetData(), ParticleData.GetComponentPtrInt32(Renderer.ParticleID.ComponentStart), NumParticles * sizeof(int32));
+	FMemory::Memcpy(SnapshotRenderer.ParticleIDs.GetData() + NumParticles, ParticleData.GetComponentPtrInt32(Renderer.ParticleID.ComponentStart + 1), NumParticles * sizeof(int32));
+
+	if (InterpolationAlpha < 1.f && Renderer.PreviousAcquireTags.Num() > 0)
+	{
+		SnapshotRenderer.PreviousPositions = Renderer.PreviousPositions;
+		SnapshotRenderer.PreviousAcquireTags = Renderer.PreviousAcquireTags;
 	}
-	else
+}
+
+// Positions of the snapshot interpolated on the mem stack, or the copied positions if there's nothing to interpolate
+static FNiagaraUIFloatStream GetSnapshotPositions(const FNiagaraUISnapshotRenderer& Renderer, const FNiagaraUIFloatStream& Position, float InterpolationAlpha)
+{
+	if (InterpolationAlpha >= 1.f || Renderer.PreviousAcquireTags.Num() == 0 || Renderer.ParticleIDs.Num() == 0 || !Position.IsBound())
+		return Position;
+
+	const int32* IDIndices = Renderer.ParticleIDs.GetData();
+	const int32* IDTags = Renderer.ParticleIDs.GetData() + Renderer.NumParticles;
+	const float* InterpolatedPositions = InterpolateParticlePositions(Renderer.PreviousPositions, Renderer.PreviousAcquireTags, Position, IDIndices, IDTags, Renderer.NumParticles, InterpolationAlpha);
+
+	return FNiagaraUIFloatStream(InterpolatedPositions, Renderer.NumParticles, FNiagaraUIFloatStream::Zeros);
+}
+
+TSharedRef<const FNiagaraUIParticleSnapshot, ESPMode::ThreadSafe> UNiagaraUIComponent::CaptureParticleSnapshot()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UNiagaraUIComponent::CaptureParticleSnapshot);
+	SCOPE_CYCLE_COUNTER(STAT_CaptureParticleSnapshot);
+
+	TSharedRef<FNiagaraUIParticleSnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FNiagaraUIParticleSnapshot, ESPMode::ThreadSafe>();
+	Snapshot->SimulationLocation = GetRelativeLocation();
+	Snapshot->MaxParticlesPerRenderer = NiagaraUICVars::MaxParticlesPerRenderer;
+
+	const FNiagaraSystemInstance* SystemInstance = IsActive() && GetSystemInstanceController() ? GetSystemInstanceController()->GetSystemInstance_Unsafe() : nullptr;
+
+	if (SystemInstance)
 	{
-		if (FullIDs)
+		UpdateRendererCache(*SystemInstance);
+
+		const auto& Emitters = SystemInstance->GetEmitters();
+
+		for (const FNiagaraUIRendererEntry& Renderer : CachedRenderers)
 		{
-			TMap<FNiagaraID, TArray<int32>> MultiRibbonSortedIndices;
+			const FNiagaraEmitterInstance& EmitterInst = Emitters[Renderer.EmitterIndex].Get();
+
+#if ENGINE_MINOR_VERSION < 4
+			FNiagaraDataSet& DataSet = EmitterInst.GetData();
+#else
+			const FNiagaraDataSet& DataSet = EmitterInst.GetParticleData();
+#endif
+
+			if (!HasEmitterParticlesToRender(EmitterInst) || !DataSet.IsCurrentDataValid())
+				continue;
+
+			FNiagaraDataBuffer& ParticleData = DataSet.GetCurrentDataChecked();
+			const int32 NumInstances = ParticleData.GetNumInstances();
 
-			for (int32 i = 0; i < ParticleCount; ++i)
+			if (Renderer.Type == FNiagaraUIRendererEntry::EType::Sprite)
 			{
-				TArray<int32>& Indices = MultiRibbonSortedIndices.FindOrAdd(RibbonFullIDData[i]);
-				Indices.Add(i);
+				if (NumInstances < 1)
+					continue;
+
+				const FNiagaraUISpriteKernelParams Particles(ParticleData, Renderer.SpriteLayout);
+				const ENiagaraUISpriteOrientation Orientation = GetSpriteOrientation(Renderer.SpriteRenderer.Get(), Particles);
+
+				FNiagaraUISnapshotRenderer& SnapshotRenderer = Snapshot->Renderers.AddDefaulted_GetRef();
+				SnapshotRenderer.Type = FNiagaraUIRendererEntry::EType::Sprite;
+				SnapshotRenderer.Material = Renderer.SpriteRenderer->Material;
+				SnapshotRenderer.LocalSpace = IsEmitterLocalSpace(EmitterInst);
+				SnapshotRenderer.NumParticles = NumInstances;
+				SnapshotRenderer.Orientation = (uint8)Orientation;
+				SnapshotRenderer.InstancedMaterial = NiagaraUICVars::InstancedSprites != 0 && IsInstancedSpriteMaterial(SnapshotRenderer.Material);
+				SnapshotRenderer.SubImageSize = FVector2f(Renderer.SpriteRenderer->SubImageSize);
+
+				// Only the streams used by the orientation are copied
+				const FNiagaraUIFloatStream& AlignmentStream = Orientation == ENiagaraUISpriteOrientation::Velocity ? Particles.Velocity : Particles.Alignment;
+				const bool Aligned = Orientation == ENiagaraUISpriteOrientation::Velocity || Orientation == ENiagaraUISpriteOrientation::Custom;
+				
+				SnapshotRenderer.Data.Reserve(NumInstances * 18);
+				SnapshotRenderer.Position = CopySnapshotStream(SnapshotRenderer, Particles.Position, 3);
+				SnapshotRenderer.Color = CopySnapshotStream(SnapshotRenderer, Particles.Color, 4);
+				SnapshotRenderer.Size = CopySnapshotStream(SnapshotRenderer, Particles.Size, 2);
+				SnapshotRenderer.Rotation = Orientation == ENiagaraUISpriteOrientation::Rotation ? CopySnapshotStream(SnapshotRenderer, Particles.Rotation, 1) : INDEX_NONE;
+				SnapshotRenderer.SubImage = CopySnapshotStream(SnapshotRenderer, Particles.SubImage, 1);
+				SnapshotRenderer.Alignment = Aligned ? CopySnapshotStream(SnapshotRenderer, AlignmentStream, 3) : INDEX_NONE;
+				SnapshotRenderer.DynamicMaterial = CopySnapshotStream(SnapshotRenderer, Particles.DynamicMaterial, 4);
+
+				CopySnapshotIDs(SnapshotRenderer, Renderer, ParticleData, InterpolationAlpha);
 			}
+			else
+			{
+				FNiagaraUIRibbonLinkData LinkData;
 
-			// Sort the ribbons by ID so that the draw order stays consistent.
-			MultiRibbonSortedIndices.KeySort(TLess<FNiagaraID>());
+				if (NumInstances < 2 || !ReadRibbonLinkData(DataSet, Renderer.RibbonRenderer.Get(), NumInstances, LinkData))
+					continue;
 
-			for (TPair<FNiagaraID, TArray<int32>>& Pair : MultiRibbonSortedIndices)
-			{
-				TArray<int32>& SortedIndices = Pair.Value;
-				RibbonLinkOrderSort(SortedIndices);
-				AddRibbonVerts(SortedIndices);
-			};
+				const FNiagaraUIRibbonLayout& Layout = Renderer.RibbonLayout;
+
+				FNiagaraUISnapshotRenderer& SnapshotRenderer = Snapshot->Renderers.AddDefaulted_GetRef();
+				SnapshotRenderer.Type = FNiagaraUIRendererEntry::EType::Ribbon;
+				SnapshotRenderer.Material = Renderer.RibbonRenderer->Material;
+				SnapshotRenderer.LocalSpace = IsEmitterLocalSpace(EmitterInst);
+				SnapshotRenderer.NumParticles = NumInstances;
+				SnapshotRenderer.RibbonUVSettings = GetRibbonUVSettings(Renderer.RibbonRenderer.Get());
+				SnapshotRenderer.RibbonLinkData = MoveTemp(LinkData);
+
+				SnapshotRenderer.Data.Reserve(NumInstances * 12);
+				SnapshotRenderer.Position = CopySnapshotStream(SnapshotRenderer, FNiagaraUIFloatStream(ParticleData, Layout.Position, FNiagaraUIFloatStream::Zeros), 3);
+				SnapshotRenderer.Color = CopySnapshotStream(SnapshotRenderer, FNiagaraUIFloatStream(ParticleData, Layout.Color, FNiagaraUIFloatStream::Ones), 4);
+				SnapshotRenderer.Size = CopySnapshotStream(SnapshotRenderer, FNiagaraUIFloatStream(ParticleData, Layout.Width, FNiagaraUIFloatStream::Ones), 1);
+				SnapshotRenderer.DynamicMaterial = CopySnapshotStream(SnapshotRenderer, FNiagaraUIFloatStream(ParticleData, Layout.DynamicMaterial, FNiagaraUIFloatStream::Zeros), 4);
+
+				CopySnapshotIDs(SnapshotRenderer, Renderer, ParticleData, InterpolationAlpha);
+			}
+
+			INC_DWORD_STAT_BY(STAT_NiagaraUISnapshotParticles, Snapshot->Renderers.Last().NumParticles);
 		}
 	}
 
+	// Captured last, as updating the renderer cache changes the state
+	Snapshot->SimulationState = GetSimulationState();
+	
+	return Snapshot;
+}
+
+void UNiagaraUIComponent::RenderSnapshot(SNiagaraUISystemWidget* NiagaraWidget, const FNiagaraUIParticleSnapshot& Snapshot, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UNiagaraUIComponent::RenderSnapshot);
+	SCOPE_CYCLE_COUNTER(STAT_RenderParticleSnapshot);
+
+	NiagaraWidget->ClearRenderData();
+
+	const float InterpolationAlpha = Snapshot.SimulationState.InterpolationAlpha;
+
+	for (const FNiagaraUISnapshotRenderer& Renderer : Snapshot.Renderers)
+	{
+		FMemMark Mark(FMemStack::Get());
+
+		const FNiagaraUIFloatStream Position = GetSnapshotPositions(Renderer, GetSnapshotStream(Renderer, Renderer.Position, FNiagaraUIFloatStream::Zeros), InterpolationAlpha);
+		const FNiagaraUIFloatStream Color = GetSnapshotStream(Renderer, Renderer.Color, FNiagaraUIFloatStream::Ones);
+		const FNiagaraUIFloatStream Size = GetSnapshotStream(Renderer, Renderer.Size, FNiagaraUIFloatStream::Ones);
+		const FNiagaraUIFloatStream DynamicMaterial = GetSnapshotStream(Renderer, Renderer.DynamicMaterial, FNiagaraUIFloatStream::Zeros);
+
+		if (Renderer.Type == FNiagaraUIRendererEntry::EType::Ribbon)
+		{
+			TArray<int32> RibbonIndices;
+			TArray<int32> RibbonEnds;
+			TArray<uint32> RibbonKeys;
+			GatherRibbons(Renderer.RibbonLinkData, Renderer.NumParticles, RibbonIndices, RibbonEnds, RibbonKeys);
+
+			AddRibbonVertices(NiagaraWidget, Renderer.Material, Renderer.RibbonUVSettings, Position, Color, Size, DynamicMaterial, Renderer.LocalSpace, Snapshot.SimulationLocation,
+								RibbonIndices, RibbonEnds, RibbonKeys, RenderProperties, WidgetProperties);
+			continue;
+		}
+
+		FNiagaraUISpriteKernelParams KernelParams;
+		KernelParams.Position = Position;
+		KernelParams.Color = Color;
+		KernelParams.Size = Size;
+		KernelParams.Rotation = GetSnapshotStream(Renderer, Renderer.Rotation, FNiagaraUIFloatStream::Zeros);
+		KernelParams.SubImage = GetSnapshotStream(Renderer, Renderer.SubImage, FNiagaraUIFloatStream::Zeros);
+		KernelParams.Velocity = GetSnapshotStream(Renderer, Renderer.Alignment, FNiagaraUIFloatStream::Zeros);
+		KernelParams.Alignment = KernelParams.Velocity;
+		KernelParams.DynamicMaterial = DynamicMaterial;
+		KernelParams.LocalSpace = Renderer.LocalSpace;
+		KernelParams.Orientation = (ENiagaraUISpriteOrientation)Renderer.Orientation;
+
+		if (Renderer.ParticleIDs.Num() > 0)
+		{
+			KernelParams.IDIndex = Renderer.ParticleIDs.GetData();
+			KernelParams.IDAcquireTag = Renderer.ParticleIDs.GetData() + Renderer.NumParticles;
+		}
+
+		const int32 ParticleCount = NiagaraUISpriteKernels::CapParticles(KernelParams, Renderer.NumParticles, Snapshot.MaxParticlesPerRenderer);
+
+		if (ParticleCount < 1)
+			continue;
+
+		AddSpriteVertices(NiagaraWidget, KernelParams, Renderer.Material, Renderer.InstancedMaterial, Renderer.SubImageSize, Snapshot.SimulationLocation, ParticleCount, RenderProperties, WidgetProperties);
+	}
 }
 
 //PRAGMA_ENABLE_OPTIMIZATION
@@ -0,0 +1,147 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "NiagaraUIConsoleVariables.h"
+#include "HAL/IConsoleManager.h"
+
+namespace NiagaraUICVars
+{
+	int32 Enable = 1;
+	static FAutoConsoleVariableRef CVarEnable(
+		TEXT("niagaraui.Enable"),
+		Enable,
+		TEXT("If 0, Niagara UI widgets don't draw any particles."),
+		ECVF_Scalability);
+
+	int32 MaxParticlesPerRenderer = 0;
+	static FAutoConsoleVariableRef CVarMaxParticlesPerRenderer(
+		TEXT("niagaraui.MaxParticlesPerRenderer"),
+		MaxParticlesPerRenderer,
+		TEXT("Maximum number of sprites drawn by one sprite renderer and of particles used by one ribbon. 0 means unlimited."),
+		ECVF_Scalability);
+
+	float RibbonDecimationTolerance = 0.f;
+	static FAutoConsoleVariableRef CVarRibbonDecimationTolerance(
+		TEXT("niagaraui.RibbonDecimationTolerance"),
+		RibbonDecimationTolerance,
+		TEXT("Ribbon particles closer than this many pixels to the line between their neighbours are skipped. 0 keeps all of them."),
+		ECVF_Scalability);
+
+	int32 UpdateRateDivisor = 1;
+	static FAutoConsoleVariableRef CVarUpdateRateDivisor(
+		TEXT("niagaraui.UpdateRateDivisor"),
+		UpdateRateDivisor,
+		TEXT("Widgets regenerate their vertices for a changed simulation only every N-th frame. Widgets that moved are always regenerated."),
+		ECVF_Scalability);
+
+	float MinParticleScreenSize = 0.f;
+	static FAutoConsoleVariableRef CVarMinParticleScreenSize(
+		TEXT("niagaraui.MinParticleScreenSize"),
+		MinParticleScreenSize,
+		TEXT("Minimum particle screen size in pixels applied to widgets with a lower Min Particle Screen Size. 0 doesn't change the widgets."),
+		ECVF_Scalability);
+
+	int32 VertexBudget = 0;
+	static FAutoConsoleVariableRef CVarVertexBudget(
+		TEXT("niagaraui.VertexBudget"),
+		VertexBudget,
+		TEXT("Maximum number of vertices generated by all Niagara UI widgets in a frame. 0 means unlimited."),
+		ECVF_Scalability);
+
+	int32 DrawBudget = 0;
+	static FAutoConsoleVariableRef CVarDrawBudget(
+		TEXT("niagaraui.DrawBudget"),
+		DrawBudget,
+		TEXT("Maximum number of draw elements submitted by all Niagara UI widgets in a frame. 0 means unlimited."),
+		ECVF_Scalability);
+
+	int32 CullParticles = 1;
+	static FAutoConsoleVariableRef CVarCullParticles(
+		TEXT("niagaraui.CullParticles"),
+		CullParticles,
+		TEXT("If 1, sprites and ribbon segments entirely outside of the widget's culling rect are not emitted."),
+		ECVF_Default);
+
+	int32 SuspendHiddenWidgets = 1;
+	static FAutoConsoleVariableRef CVarSuspendHiddenWidgets(
+		TEXT("niagaraui.SuspendHiddenWidgets"),
+		SuspendHiddenWidgets,
+		TEXT("If 0, the Hidden Policy of the widgets is ignored and hidden widgets keep simulating."),
+		ECVF_Default);
+
+	int32 SpriteKernel = 1;
+	static FAutoConsoleVariableRef CVarSpriteKernel(
+		TEXT("niagaraui.SpriteKernel"),
+		SpriteKernel,
+		TEXT("Sprite vertex kernels to use. 0: scalar, 1: SIMD, four particles at a time."),
+		ECVF_Default);
+
+	int32 ParallelSpriteThreshold = 4096;
+	static FAutoConsoleVariableRef CVarParallelSpriteThreshold(
+		TEXT("niagaraui.ParallelSpriteThreshold"),
+		ParallelSpriteThreshold,
+		TEXT("Sprite renderers with at least this many particles generate their vertices on multiple threads. 0 disables parallel generation."),
+		ECVF_Default);
+
+	int32 ParallelSpriteChunkSize = 1024;
+	static FAutoConsoleVariableRef CVarParallelSpriteChunkSize(
+		TEXT("niagaraui.ParallelSpriteChunkSize"),
+		ParallelSpriteChunkSize,
+		TEXT("Number of particles processed by one task of the parallel sprite vertex generation."),
+		ECVF_Default);
+
+	int32 AsyncVertexGeneration = 0;
+	static FAutoConsoleVariableRef CVarAsyncVertexGeneration(
+		TEXT("niagaraui.AsyncVertexGeneration"),
+		AsyncVertexGeneration,
+		TEXT("If 1, all widgets copy their particles before Slate ticks and generate their vertices from the copy on worker threads, only publishing them when painted. Widgets that moved since their last paint are still generated synchronously."),
+		ECVF_Default);
+
+	int32 ParticleSnapshots = 1;
+	static FAutoConsoleVariableRef CVarParticleSnapshots(
+		TEXT("niagaraui.ParticleSnapshots"),
+		ParticleSnapshots,
+		TEXT("Widgets using particle snapshots copy their particles before Slate ticks and build the vertices from the copy on worker threads. 0 disables them, 1 enables them for widgets with Use Particle Snapshot, 2 for all widgets."),
+		ECVF_Default);
+
+	int32 InstancedSprites = 1;
+	static FAutoConsoleVariableRef CVarInstancedSprites(
+		TEXT("niagaraui.InstancedSprites"),
+		InstancedSprites,
+		TEXT("If 1, widgets with Use Instanced Sprites upload one packed record per sprite and let their materials expand it. If 0, all sprites are generated as vertices."),
+		ECVF_Default);
+
+	int32 MergeRenderSlots = 1;
+	static FAutoConsoleVariableRef CVarMergeRenderSlots(
+		TEXT("niagaraui.MergeRenderSlots"),
+		MergeRenderSlots,
+		TEXT("If 1, consecutive renderers of a widget drawn with the same material after remapping are merged into a single draw element."),
+		ECVF_Default);
+
+	float BudgetMinFraction = 0.1f;
+	static FAutoConsoleVariableRef CVarBudgetMinFraction(
+		TEXT("niagaraui.BudgetMinFraction"),
+		BudgetMinFraction,
+		TEXT("Widgets that would get less than this fraction of their particles from the vertex budget are skipped instead."),
+		ECVF_Default);
+
+	float BudgetLogInterval = 5.f;
+	static FAutoConsoleVariableRef CVarBudgetLogInterval(
+		TEXT("niagaraui.BudgetLogInterval"),
+		BudgetLogInterval,
+		TEXT("Minimum number of seconds between warnings about the Niagara UI budget being exceeded."),
+		ECVF_Default);
+
+	int32 ComponentPoolSize = 8;
+	static FAutoConsoleVariableRef CVarComponentPoolSize(
+		TEXT("niagaraui.ComponentPoolSize"),
+		ComponentPoolSize,
+		TEXT("Maximum number of released UI particle components kept per Niagara system for reuse. 0 disables pooling."),
+		ECVF_Default);
+
+	float ComponentPoolCleanupTime = 30.f;
+	static FAutoConsoleVariableRef CVarComponentPoolCleanupTime(
+		TEXT("niagaraui.ComponentPoolCleanupTime"),
+		ComponentPoolCleanupTime,
+		TEXT("Pooled UI particle components unused for this many seconds are destroyed."),
+		ECVF_Default);
+}
@@ -0,0 +1,42 @@
+// Copyright 2024 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * All niagaraui.* console variables. Variables flagged as scalability are set from UNiagaraUISettings whenever sg.EffectsQuality changes,
+ * the rest get their project defaults from the same settings. Device profiles and the console can override both
+ */
+namespace NiagaraUICVars
+{
+	// Scalability
+	extern int32 Enable;
+	extern int32 MaxParticlesPerRenderer;
+	extern float RibbonDecimationTolerance;
+	extern int32 UpdateRateDivisor;
+	extern float MinParticleScreenSize;
+	extern int32 VertexBudget;
+	extern int32 DrawBudget;
+
+	// Culling
+	extern int32 CullParticles;
+	extern int32 SuspendHiddenWidgets;
+
+	// Vertex generation
+	extern int32 SpriteKernel;
+	extern int32 ParallelSpriteThreshold;
+	extern int32 ParallelSpriteChunkSize;
+	extern int32 AsyncVertexGeneration;
+	extern int32 ParticleSnapshots;
+	extern int32 InstancedSprites;
+	extern int32 MergeRenderSlots;
+
+	// Budget
+	extern float BudgetMinFraction;
+	extern float BudgetLogInterval;
+
+	// Component pool
+	extern int32 ComponentPoolSize;
+	extern float ComponentPoolCleanupTime;
+}
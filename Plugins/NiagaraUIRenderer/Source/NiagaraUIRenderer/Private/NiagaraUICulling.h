@@ -0,0 +1,58 @@
+// Copyright 2024 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Layout/SlateRect.h"
+#include "Rendering/RenderingCommon.h"
+
+namespace NiagaraUICulling
+{
+	// True if the bounds of the four consecutive vertices don't overlap the rect
+	FORCEINLINE bool IsQuadOutside(const FSlateVertex* Vertices, const FSlateRect& CullingRect)
+	{
+		float MinX = Vertices[0].Position.X;
+		float MaxX = MinX;
+		float MinY = Vertices[0].Position.Y;
+		float MaxY = MinY;
+
+		for (int32 i = 1; i < 4; ++i)
+		{
+			MinX = FMath::Min(MinX, Vertices[i].Position.X);
+			MaxX = FMath::Max(MaxX, Vertices[i].Position.X);
+			MinY = FMath::Min(MinY, Vertices[i].Position.Y);
+			MaxY = FMath::Max(MaxY, Vertices[i].Position.Y);
+		}
+
+		return MaxX < CullingRect.Left || MinX > CullingRect.Right || MaxY < CullingRect.Top || MinY > CullingRect.Bottom;
+	}
+
+	// True if the quad has no area, e.g. because its particle was dropped
+	FORCEINLINE bool IsQuadDegenerate(const FSlateVertex* Vertices)
+	{
+		return Vertices[0].Position == Vertices[3].Position && Vertices[1].Position == Vertices[2].Position;
+	}
+
+	// Moves the quads with some area overlapping the rect to the front of the vertex data, keeping their order. Invalid rect culls nothing. Returns the number of kept quads
+	inline int32 CompactVisibleQuads(FSlateVertex* VertexData, int32 NumQuads, const FSlateRect& CullingRect)
+	{
+		const bool Cull = CullingRect.IsValid();
+		
+		int32 NumVisibleQuads = 0;
+		
+		for (int32 QuadIndex = 0; QuadIndex < NumQuads; ++QuadIndex)
+		{
+			const FSlateVertex* QuadVertices = VertexData + QuadIndex * 4;
+			
+			if (IsQuadDegenerate(QuadVertices) || (Cull && IsQuadOutside(QuadVertices, CullingRect)))
+				continue;
+
+			if (NumVisibleQuads != QuadIndex)
+				FMemory::Memcpy(VertexData + NumVisibleQuads * 4, QuadVertices, 4 * sizeof(FSlateVertex));
+
+			++NumVisibleQuads;
+		}
+
+		return NumVisibleQuads;
+	}
+}
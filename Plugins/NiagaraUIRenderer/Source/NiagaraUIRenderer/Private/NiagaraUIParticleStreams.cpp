@@ -0,0 +1,98 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "NiagaraUIParticleStreams.h"
+#include "NiagaraDataSet.h"
+#include "NiagaraSpriteRendererProperties.h"
+#include "NiagaraRibbonRendererProperties.h"
+
+const float FNiagaraUIFloatStream::Zeros[4] = { 0.f, 0.f, 0.f, 0.f };
+const float FNiagaraUIFloatStream::Ones[4] = { 1.f, 1.f, 1.f, 1.f };
+
+void FNiagaraUIFloatAttribute::Resolve(const FNiagaraDataSet& DataSet, FName AttributeName, int32 NumComponents)
+{
+	ComponentStart = INDEX_NONE;
+
+	const FNiagaraDataSetCompiledData& CompiledData = DataSet.GetCompiledData();
+	const int32 VariableIndex = CompiledData.Variables.IndexOfByPredicate([AttributeName](const auto& Variable) { return Variable.GetName() == AttributeName; });
+
+	if (VariableIndex == INDEX_NONE)
+		return;
+
+	// Attributes stored as half or int, or with a different type than we expect are treated as unbound
+	const FNiagaraVariableLayoutInfo& Layout = CompiledData.VariableLayouts[VariableIndex];
+	
+	if ((int32)Layout.GetNumFloatComponents() != NumComponents)
+		return;
+
+	ComponentStart = Layout.GetFloatComponentStart();
+}
+
+void FNiagaraUIInt32Attribute::Resolve(const FNiagaraDataSet& DataSet, FName AttributeName, int32 NumComponents)
+{
+	ComponentStart = INDEX_NONE;
+
+	const FNiagaraDataSetCompiledData& CompiledData = DataSet.GetCompiledData();
+	const int32 VariableIndex = CompiledData.Variables.IndexOfByPredicate([AttributeName](const auto& Variable) { return Variable.GetName() == AttributeName; });
+
+	if (VariableIndex == INDEX_NONE)
+		return;
+
+	const FNiagaraVariableLayoutInfo& Layout = CompiledData.VariableLayouts[VariableIndex];
+	
+	if ((int32)Layout.GetNumInt32Components() != NumComponents)
+		return;
+
+	ComponentStart = Layout.GetInt32ComponentStart();
+}
+
+FNiagaraUIFloatStream::FNiagaraUIFloatStream(const FNiagaraDataBuffer& Buffer, const FNiagaraUIFloatAttribute& Attribute, const float* DefaultValue)
+{
+	if (Attribute.IsBound())
+	{
+		Data = reinterpret_cast<const float*>(Buffer.GetComponentPtrFloat(Attribute.ComponentStart));
+		ComponentStride = Buffer.GetFloatStride() / sizeof(float);
+		IndexMask = ~0;
+	}
+	else
+	{
+		Data = DefaultValue;
+		ComponentStride = 1;
+		IndexMask = 0;
+	}
+}
+
+FNiagaraUIFloatStream::FNiagaraUIFloatStream(const float* InData, int32 InComponentStride, const float* DefaultValue)
+{
+	if (InData)
+	{
+		Data = InData;
+		ComponentStride = InComponentStride;
+		IndexMask = ~0;
+	}
+	else
+	{
+		Data = DefaultValue;
+		ComponentStride = 1;
+		IndexMask = 0;
+	}
+}
+
+void FNiagaraUISpriteLayout::Resolve(const FNiagaraDataSet& DataSet, const UNiagaraSpriteRendererProperties* SpriteRenderer)
+{
+	Position		.Resolve(DataSet, SpriteRenderer->PositionBinding.GetDataSetBindableVariable().GetName(), 3);
+	Color			.Resolve(DataSet, SpriteRenderer->ColorBinding.GetDataSetBindableVariable().GetName(), 4);
+	Velocity		.Resolve(DataSet, SpriteRenderer->VelocityBinding.GetDataSetBindableVariable().GetName(), 3);
+	Alignment		.Resolve(DataSet, SpriteRenderer->SpriteAlignmentBinding.GetDataSetBindableVariable().GetName(), 3);
+	Size			.Resolve(DataSet, SpriteRenderer->SpriteSizeBinding.GetDataSetBindableVariable().GetName(), 2);
+	Rotation		.Resolve(DataSet, SpriteRenderer->SpriteRotationBinding.GetDataSetBindableVariable().GetName(), 1);
+	SubImage		.Resolve(DataSet, SpriteRenderer->SubImageIndexBinding.GetDataSetBindableVariable().GetName(), 1);
+	DynamicMaterial	.Resolve(DataSet, SpriteRenderer->DynamicMaterialBinding.GetDataSetBindableVariable().GetName(), 4);
+}
+
+void FNiagaraUIRibbonLayout::Resolve(const FNiagaraDataSet& DataSet, const UNiagaraRibbonRendererProperties* RibbonRenderer)
+{
+	Position		.Resolve(DataSet, RibbonRenderer->PositionBinding.GetDataSetBindableVariable().GetName(), 3);
+	Color			.Resolve(DataSet, RibbonRenderer->ColorBinding.GetDataSetBindableVariable().GetName(), 4);
+	Width			.Resolve(DataSet, RibbonRenderer->RibbonWidthBinding.GetDataSetBindableVariable().GetName(), 1);
+	DynamicMaterial	.Resolve(DataSet, RibbonRenderer->DynamicMaterialBinding.GetDataSetBindableVariable().GetName(), 4);
+}
@@ -1,18 +1,56 @@
 // Copyright 2024 - Michal Smoleň
 
 #include "NiagaraUIRenderer.h"
+#include "NiagaraUISpriteIndexBuffer.h"
+#include "NiagaraUISettings.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+#include "Interfaces/IPluginManager.h"
+#include "ShaderCore.h"
 
 #define LOCTEXT_NAMESPACE "FNiagaraUIRendererModule"
 
+DEFINE_LOG_CATEGORY(LogNiagaraUIRenderer);
+
 void FNiagaraUIRendererModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+
+	PostEngineInitHandle = FCoreDelegates::OnPostEngineInit.AddRaw(this, &FNiagaraUIRendererModule::OnPostEngineInit);
+
+	// Lets the sprite materials include /Plugin/NiagaraUIRenderer/Private/NiagaraUIInstancedSprite.ush from their Custom nodes
+	const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("NiagaraUIRenderer"));
+
+	if (Plugin.IsValid() && !AllShaderSourceDirectoryMappings().Contains(TEXT("/Plugin/NiagaraUIRenderer")))
+		AddShaderSourceDirectoryMapping(TEXT("/Plugin/NiagaraUIRenderer"), FPaths::Combine(Plugin->GetBaseDir(), TEXT("Shaders")));
 }
 
 void FNiagaraUIRendererModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+
+	FNiagaraUISpriteIndexBuffer::Reset();
+
+	FCoreDelegates::OnPostEngineInit.Remove(PostEngineInitHandle);
+
+	if (IConsoleVariable* EffectsQuality = IConsoleManager::Get().FindConsoleVariable(TEXT("sg.EffectsQuality")))
+		EffectsQuality->OnChangedDelegate().Remove(EffectsQualityChangedHandle);
+}
+
+void FNiagaraUIRendererModule::OnPostEngineInit()
+{
+	GetDefault<UNiagaraUISettings>()->ApplySettings();
+
+	// Scalability changes are applied on top of the project defaults, device profile and console overrides keep their priority
+	if (IConsoleVariable* EffectsQuality = IConsoleManager::Get().FindConsoleVariable(TEXT("sg.EffectsQuality")))
+		EffectsQualityChangedHandle = EffectsQuality->OnChangedDelegate().AddRaw(this, &FNiagaraUIRendererModule::OnEffectsQualityChanged);
+}
+
+void FNiagaraUIRendererModule::OnEffectsQualityChanged(IConsoleVariable* Variable)
+{
+	GetDefault<UNiagaraUISettings>()->ApplySettings();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,88 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "NiagaraUISettings.h"
+#include "HAL/IConsoleManager.h"
+
+namespace NiagaraUISettings
+{
+	template<typename ValueType>
+	void SetConsoleVariable(const TCHAR* Name, ValueType Value, EConsoleVariableFlags SetBy)
+	{
+		if (IConsoleVariable* ConsoleVariable = IConsoleManager::Get().FindConsoleVariable(Name))
+			ConsoleVariable->Set(Value, SetBy);
+	}
+}
+
+UNiagaraUISettings::UNiagaraUISettings()
+{
+	// Lower quality levels trade some of the particle detail for cheaper vertex generation
+	Low.MaxParticlesPerRenderer = 256;
+	Low.RibbonDecimationTolerance = 2.f;
+	Low.UpdateRateDivisor = 2;
+	Low.MinParticleScreenSize = 1.f;
+
+	Medium.MaxParticlesPerRenderer = 1024;
+	Medium.RibbonDecimationTolerance = 1.f;
+	Medium.MinParticleScreenSize = 0.5f;
+}
+
+FName UNiagaraUISettings::GetCategoryName() const
+{
+	return TEXT("Plugins");
+}
+
+#if WITH_EDITOR
+void UNiagaraUISettings::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	ApplySettings();
+}
+#endif
+
+void UNiagaraUISettings::ApplySettings() const
+{
+	using namespace NiagaraUISettings;
+
+	const IConsoleVariable* EffectsQuality = IConsoleManager::Get().FindConsoleVariable(TEXT("sg.EffectsQuality"));
+	const FNiagaraUIQualityLevelSettings& Quality = GetQualityLevelSettings(EffectsQuality ? EffectsQuality->GetInt() : 3);
+
+	SetConsoleVariable(TEXT("niagaraui.Enable"), Quality.Enable ? 1 : 0, ECVF_SetByScalability);
+	SetConsoleVariable(TEXT("niagaraui.MaxParticlesPerRenderer"), Quality.MaxParticlesPerRenderer, ECVF_SetByScalability);
+	SetConsoleVariable(TEXT("niagaraui.RibbonDecimationTolerance"), Quality.RibbonDecimationTolerance, ECVF_SetByScalability);
+	SetConsoleVariable(TEXT("niagaraui.UpdateRateDivisor"), Quality.UpdateRateDivisor, ECVF_SetByScalability);
+	SetConsoleVariable(TEXT("niagaraui.MinParticleScreenSize"), Quality.MinParticleScreenSize, ECVF_SetByScalability);
+	SetConsoleVariable(TEXT("niagaraui.VertexBudget"), Quality.VertexBudget, ECVF_SetByScalability);
+	SetConsoleVariable(TEXT("niagaraui.DrawBudget"), Quality.DrawBudget, ECVF_SetByScalability);
+
+	SetConsoleVariable(TEXT("niagaraui.CullParticles"), CullParticles ? 1 : 0, ECVF_SetByProjectSetting);
+	SetConsoleVariable(TEXT("niagaraui.SuspendHiddenWidgets"), SuspendHiddenWidgets ? 1 : 0, ECVF_SetByProjectSetting);
+	SetConsoleVariable(TEXT("niagaraui.SpriteKernel"), UseSIMDSpriteKernel ? 1 : 0, ECVF_SetByProjectSetting);
+	SetConsoleVariable(TEXT("niagaraui.ParallelSpriteThreshold"), ParallelSpriteThreshold, ECVF_SetByProjectSetting);
+	SetConsoleVariable(TEXT("niagaraui.ParallelSpriteChunkSize"), ParallelSpriteChunkSize, ECVF_SetByProjectSetting);
+	SetConsoleVariable(TEXT("niagaraui.AsyncVertexGeneration"), AsyncVertexGeneration ? 1 : 0, ECVF_SetByProjectSetting);
+	SetConsoleVariable(TEXT("niagaraui.ParticleSnapshots"), ParticleSnapshots, ECVF_SetByProjectSetting);
+	SetConsoleVariable(TEXT("niagaraui.InstancedSprites"), InstancedSprites ? 1 : 0, ECVF_SetByProjectSetting);
+	SetConsoleVariable(TEXT("niagaraui.MergeRenderSlots"), MergeRenderSlots ? 1 : 0, ECVF_SetByProjectSetting);
+	SetConsoleVariable(TEXT("niagaraui.BudgetMinFraction"), BudgetMinFraction, ECVF_SetByProjectSetting);
+	SetConsoleVariable(TEXT("niagaraui.BudgetLogInterval"), BudgetLogInterval, ECVF_SetByProjectSetting);
+	SetConsoleVariable(TEXT("niagaraui.ComponentPoolSize"), ComponentPoolSize, ECVF_SetByProjectSetting);
+	SetConsoleVariable(TEXT("niagaraui.ComponentPoolCleanupTime"), ComponentPoolCleanupTime, ECVF_SetByProjectSetting);
+}
+
+const FNiagaraUIQualityLevelSettings& UNiagaraUISettings::GetQualityLevelSettings(int32 QualityLevel) const
+{
+	switch (QualityLevel)
+	{
+	case 0:
+		return Low;
+	case 1:
+		return Medium;
+	case 2:
+		return High;
+	case 3:
+		return Epic;
+	default:
+		return Cinematic;
+	}
+}
@@ -0,0 +1,70 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "NiagaraUISpriteIndexBuffer.h"
+#include "Misc/ScopeRWLock.h"
+
+TArray<SlateIndex> FNiagaraUISpriteIndexBuffer::Indices;
+FRWLock FNiagaraUISpriteIndexBuffer::IndicesLock;
+
+void FNiagaraUISpriteIndexBuffer::CopyIndices(SlateIndex* OutIndexData, int32 NumSprites)
+{
+	CopyIndices(OutIndexData, 0, NumSprites);
+}
+
+void FNiagaraUISpriteIndexBuffer::CopyIndices(SlateIndex* OutIndexData, int32 FirstSprite, int32 NumSprites)
+{
+	if (NumSprites < 1)
+		return;
+
+	const int32 FirstIndex = FirstSprite * IndicesPerSprite;
+	const int32 NumIndices = NumSprites * IndicesPerSprite;
+	
+	{
+		FReadScopeLock ReadLock(IndicesLock);
+
+		if (Indices.Num() >= FirstIndex + NumIndices)
+		{
+			FMemory::Memcpy(OutIndexData + FirstIndex, Indices.GetData() + FirstIndex, NumIndices * sizeof(SlateIndex));
+			return;
+		}
+	}
+
+	Grow(FirstSprite + NumSprites);
+
+	FReadScopeLock ReadLock(IndicesLock);
+	FMemory::Memcpy(OutIndexData + FirstIndex, Indices.GetData() + FirstIndex, NumIndices * sizeof(SlateIndex));
+}
+
+void FNiagaraUISpriteIndexBuffer::Reset()
+{
+	FWriteScopeLock WriteLock(IndicesLock);
+	Indices.Empty();
+}
+
+void FNiagaraUISpriteIndexBuffer::Grow(int32 NumSprites)
+{
+	FWriteScopeLock WriteLock(IndicesLock);
+
+	const int32 CachedSprites = Indices.Num() / IndicesPerSprite;
+	
+	// Another thread might have grown the buffer while we were waiting for the lock
+	if (CachedSprites >= NumSprites)
+		return;
+
+	const int32 NewNumSprites = FMath::RoundUpToPowerOfTwo(NumSprites);
+	Indices.SetNumUninitialized(NewNumSprites * IndicesPerSprite);
+
+	for (int32 SpriteIndex = CachedSprites; SpriteIndex < NewNumSprites; ++SpriteIndex)
+	{
+		const int32 VertexIndex = SpriteIndex * VerticesPerSprite;
+		SlateIndex* SpriteIndices = &Indices[SpriteIndex * IndicesPerSprite];
+		
+		SpriteIndices[0] = VertexIndex;
+		SpriteIndices[1] = VertexIndex + 1;
+		SpriteIndices[2] = VertexIndex + 2;
+		
+		SpriteIndices[3] = VertexIndex + 2;
+		SpriteIndices[4] = VertexIndex + 1;
+		SpriteIndices[5] = VertexIndex + 3;
+	}
+}
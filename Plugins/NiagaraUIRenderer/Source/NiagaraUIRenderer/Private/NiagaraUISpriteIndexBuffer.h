@@ -0,0 +1,33 @@
+// Copyright 2024 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Rendering/RenderingCommon.h"
+
+/**
+ * Process-wide, grow-only cache of the sprite quad index pattern (0-1-2 / 2-1-3 for every quad).
+ * The pattern depends only on the number of sprites, so sprite renderers copy it in bulk instead of regenerating it every frame.
+ */
+class FNiagaraUISpriteIndexBuffer
+{
+public:
+	static constexpr int32 IndicesPerSprite = 6;
+	static constexpr int32 VerticesPerSprite = 4;
+	
+	// Copies the index pattern for NumSprites quads into OutIndexData, which needs to have room for NumSprites * IndicesPerSprite indices. Thread safe
+	static void CopyIndices(SlateIndex* OutIndexData, int32 NumSprites);
+	
+	// Copies the index pattern of sprites [FirstSprite, FirstSprite + NumSprites) into the same range of OutIndexData. Lets several threads fill disjoint parts of one index buffer
+	static void CopyIndices(SlateIndex* OutIndexData, int32 FirstSprite, int32 NumSprites);
+
+	// Releases the cached indices
+	static void Reset();
+
+private:
+	static void Grow(int32 NumSprites);
+
+private:
+	static TArray<SlateIndex> Indices;
+	static FRWLock IndicesLock;
+};
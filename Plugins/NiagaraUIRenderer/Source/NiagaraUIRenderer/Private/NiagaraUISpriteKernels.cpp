@@ -0,0 +1,787 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "NiagaraUISpriteKernels.h"
+#include "NiagaraUIColorConversion.h"
+#include "Rendering/RenderingCommon.h"
+#include "Templates/IntegerSequence.h"
+#include "NiagaraUIConsoleVariables.h"
+#include "NiagaraUISpriteIndexBuffer.h"
+#include "NiagaraUICulling.h"
+#include "NiagaraUIStats.h"
+#include "Async/ParallelFor.h"
+#include "Misc/MemStack.h"
+
+DECLARE_CYCLE_STAT(TEXT("Generate Sprite Data (Parallel)"), STAT_GenerateSpriteDataParallel, STATGROUP_NiagaraUI);
+
+FNiagaraUISpriteKernelParams::FNiagaraUISpriteKernelParams(const FNiagaraDataBuffer& Buffer, const FNiagaraUISpriteLayout& Layout)
+	: Position			(Buffer, Layout.Position,			FNiagaraUIFloatStream::Zeros)
+	, Color				(Buffer, Layout.Color,				FNiagaraUIFloatStream::Ones)
+	, Velocity			(Buffer, Layout.Velocity,			FNiagaraUIFloatStream::Zeros)
+	, Alignment			(Buffer, Layout.Alignment,			FNiagaraUIFloatStream::Zeros)
+	, Size				(Buffer, Layout.Size,				FNiagaraUIFloatStream::Ones)
+	, Rotation			(Buffer, Layout.Rotation,			FNiagaraUIFloatStream::Zeros)
+	, SubImage			(Buffer, Layout.SubImage,			FNiagaraUIFloatStream::Zeros)
+	, DynamicMaterial	(Buffer, Layout.DynamicMaterial,	FNiagaraUIFloatStream::Zeros)
+{
+}
+
+FNiagaraUISpriteKernelParams::FNiagaraUISpriteKernelParams()
+	: Position			(nullptr, 0, FNiagaraUIFloatStream::Zeros)
+	, Color				(nullptr, 0, FNiagaraUIFloatStream::Ones)
+	, Velocity			(nullptr, 0, FNiagaraUIFloatStream::Zeros)
+	, Alignment			(nullptr, 0, FNiagaraUIFloatStream::Zeros)
+	, Size				(nullptr, 0, FNiagaraUIFloatStream::Ones)
+	, Rotation			(nullptr, 0, FNiagaraUIFloatStream::Zeros)
+	, SubImage			(nullptr, 0, FNiagaraUIFloatStream::Zeros)
+	, DynamicMaterial	(nullptr, 0, FNiagaraUIFloatStream::Zeros)
+{
+}
+
+namespace NiagaraUISpriteKernels
+{
+	enum EKernelFlags : uint32
+	{
+		KernelFlag_LocalSpace		= 1 << 0,
+		KernelFlag_FakeDepth		= 1 << 1,
+		KernelFlag_SubImage			= 1 << 2,
+		KernelFlag_Color			= 1 << 3,
+		KernelFlag_DynamicMaterial	= 1 << 4,
+		KernelFlag_Thinning			= 1 << 5,
+
+		// Remaining bits hold the ENiagaraUISpriteOrientation
+		KernelFlag_OrientationShift	= 6,
+
+		NumKernels					= 4 << KernelFlag_OrientationShift
+	};
+
+	using FKernelFunction = void(*)(const FNiagaraUISpriteKernelParams&, int32, int32);
+	
+	FORCEINLINE FVector2f FastRotate(const FVector2f Vector, float Sin, float Cos)
+	{
+		return FVector2f(Cos * Vector.X - Sin * Vector.Y,
+						 Sin * Vector.X + Cos * Vector.Y);
+	}
+
+	// Budget thinning hashes offset keys, so it doesn't pick the same particles as the sub-pixel thinning
+	static constexpr uint32 BudgetHashOffset = 0x9e3779b9u;
+
+	// Particle cap uses yet another offset, so the budget thinning of the capped particles still keeps its fraction of them
+	static constexpr uint32 CapHashOffset = 0x7f4a7c15u;
+	
+	// Value hashed by the thinning. Buffer indices shift whenever a particle dies, persistent IDs stay with the particle
+	FORCEINLINE uint32 GetThinningKey(const FNiagaraUISpriteKernelParams& Params, int32 ParticleIndex)
+	{
+		if (!Params.IDIndex)
+			return ParticleIndex;
+
+		return (uint32)Params.IDIndex[ParticleIndex] * 0x85ebca77u + (uint32)Params.IDAcquireTag[ParticleIndex];
+	}
+
+	// Collapses all four vertices into one point. Such quads are removed when the sprites are compacted
+	FORCEINLINE void WriteDroppedQuad(FSlateVertex* Vertices, const FVector2f Position)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			Vertices[i].Position = Position;
+			Vertices[i].Color = FColor::Transparent;
+		}
+	}
+
+	template<uint32 Flags>
+	void SpriteKernel(const FNiagaraUISpriteKernelParams& Params, int32 StartIndex, int32 EndIndex)
+	{
+		constexpr bool LocalSpace = (Flags & KernelFlag_LocalSpace) != 0;
+		constexpr bool FakeDepth = (Flags & KernelFlag_FakeDepth) != 0;
+		constexpr bool SubImage = (Flags & KernelFlag_SubImage) != 0;
+		constexpr bool HasColor = (Flags & KernelFlag_Color) != 0;
+		constexpr bool HasDynamicMaterial = (Flags & KernelFlag_DynamicMaterial) != 0;
+		constexpr bool Thinning = (Flags & KernelFlag_Thinning) != 0;
+		constexpr ENiagaraUISpriteOrientation Orientation = (ENiagaraUISpriteOrientation)(Flags >> KernelFlag_OrientationShift);
+		constexpr bool Aligned = Orientation == ENiagaraUISpriteOrientation::Velocity || Orientation == ENiagaraUISpriteOrientation::Custom;
+
+		// Local space particles are scaled, rotated and offset by the widget transform, world space ones only by the layout scale and the offset from the simulation
+		const FVector2f PositionScale = LocalSpace ? Params.ComponentScale * Params.ScaleFactor : FVector2f(Params.ScaleFactor, Params.ScaleFactor);
+		const FVector2f PositionOffset = Params.ParentTopLeft + (LocalSpace ? Params.ComponentOffset : Params.WorldSpaceOffset);
+
+		float WidgetSin, WidgetCos;
+		FMath::SinCos(&WidgetSin, &WidgetCos, FMath::DegreesToRadians(-Params.WidgetRotationAngle));
+		const float WidgetRotationAngleRadians = FMath::DegreesToRadians(Params.WidgetRotationAngle);
+		
+		const float FakeDepthScaler = 1.f / Params.FakeDepthScaleDistance;
+		
+		const FVector2f SubImageSize = Params.SubImageSize;
+		const FVector2f SubImageDelta = FVector2f::UnitVector / SubImageSize;
+
+		// Values of unbound attributes are the same for every particle
+		const FColor ConstantColor = FNiagaraUIColorConversion::ToFColorSRGB(FLinearColor::White, Params.Tint);
+		const float ConstantSin = LocalSpace ? WidgetSin : 0.f;
+		const float ConstantCos = LocalSpace ? WidgetCos : 1.f;
+
+		const float* RotationData = Params.Rotation.GetComponentData(0);
+		const float* SubImageData = Params.SubImage.GetComponentData(0);
+		const float* DynamicMaterialX = Params.DynamicMaterial.GetComponentData(0);
+		const float* DynamicMaterialY = Params.DynamicMaterial.GetComponentData(1);
+		
+		const FNiagaraUIFloatStream& AlignmentData = Orientation == ENiagaraUISpriteOrientation::Velocity ? Params.Velocity : Params.Alignment;
+		
+		for (int32 ParticleIndex = StartIndex; ParticleIndex < EndIndex; ++ParticleIndex)
+		{
+			FVector2f ParticlePosition = FVector2f(Params.Position.Get(0, ParticleIndex), -Params.Position.Get(2, ParticleIndex)) * PositionScale;
+			FVector2f ParticleSize = Params.Size.GetVector2(ParticleIndex) * PositionScale;
+
+			if (LocalSpace)
+				ParticlePosition = FastRotate(ParticlePosition, WidgetSin, WidgetCos);
+
+			ParticlePosition += PositionOffset;
+			
+			if (FakeDepth)
+			{
+				const float ParticleDepth = (-Params.Position.Get(1, ParticleIndex) + Params.FakeDepthScaleDistance) * FakeDepthScaler;
+				ParticleSize *= ParticleDepth;
+			}
+
+			float AlphaScale = 1.f;
+
+			if (Thinning && Params.KeepFraction < 1.f && HashParticleIndex(GetThinningKey(Params, ParticleIndex) + BudgetHashOffset) >= Params.KeepFraction)
+			{
+				WriteDroppedQuad(Params.VertexData + ParticleIndex * 4, ParticlePosition);
+				continue;
+			}
+			
+			if (Thinning && Params.MinScreenSize > 0.f)
+			{
+				const float ScreenSize = FMath::Max(FMath::Abs(ParticleSize.X), FMath::Abs(ParticleSize.Y));
+				const float Coverage = ScreenSize / Params.MinScreenSize;
+
+				if (Coverage < 1.f)
+				{
+					if (!Params.ThinSubPixelParticles || HashParticleIndex(GetThinningKey(Params, ParticleIndex)) >= Coverage)
+					{
+						WriteDroppedQuad(Params.VertexData + ParticleIndex * 4, ParticlePosition);
+						continue;
+					}
+
+					// Kept particles are drawn at the minimum size with their alpha scaled down, so the expected coverage stays the same
+					ParticleSize /= Coverage;
+					AlphaScale = Coverage;
+				}
+			}
+
+			const FVector2f ParticleHalfSize = ParticleSize * 0.5f;
+
+			FColor ParticleColor = ConstantColor;
+
+			if (HasColor || AlphaScale < 1.f)
+			{
+				FLinearColor ParticleTint = Params.Tint;
+				ParticleTint.A *= AlphaScale;
+				
+				ParticleColor = FNiagaraUIColorConversion::ToFColorSRGB(HasColor ? Params.Color.GetColor(ParticleIndex) : FLinearColor::White, ParticleTint);
+			}
+
+			float ParticleRotationSin = ConstantSin;
+			float ParticleRotationCos = ConstantCos;
+
+			if (Aligned)
+			{
+				const FVector2f AlignmentVector = FVector2f(AlignmentData.Get(0, ParticleIndex), AlignmentData.Get(2, ParticleIndex));
+				
+				ParticleRotationCos = AlignmentVector.GetSafeNormal().Y;
+				const float SinSign = AlignmentVector.X >= 0.f ? 1.f : -1.f;
+
+				if (LocalSpace)
+				{
+					const float ParticleRotation = FMath::Acos(ParticleRotationCos) * SinSign - WidgetRotationAngleRadians;
+					FMath::SinCos(&ParticleRotationSin, &ParticleRotationCos, ParticleRotation);
+				}
+				else
+				{
+					ParticleRotationSin = FMath::Sqrt(1.f - ParticleRotationCos * ParticleRotationCos) * SinSign;
+				}
+			}
+			else if (Orientation == ENiagaraUISpriteOrientation::Rotation)
+			{
+				float ParticleRotation = RotationData[ParticleIndex];
+
+				if (LocalSpace)
+					ParticleRotation -= Params.WidgetRotationAngle;
+
+				FMath::SinCos(&ParticleRotationSin, &ParticleRotationCos, FMath::DegreesToRadians(ParticleRotation));
+			}
+
+			// Unbound sub image index always shows the first frame
+			float LeftUV = 0.f;
+			float RightUV = SubImageDelta.X;
+			float TopUV = 0.f;
+			float BottomUV = SubImageDelta.Y;
+
+			if (SubImage)
+			{
+				const float ParticleSubImage = SubImageData[ParticleIndex];
+				const int Row = (int)FMath::Floor(ParticleSubImage / SubImageSize.X) % (int)SubImageSize.Y;
+				const int Column = (int)(ParticleSubImage) % (int)(SubImageSize.X);
+
+				LeftUV = SubImageDelta.X * Column;
+				RightUV = SubImageDelta.X * (Column + 1);
+				TopUV = SubImageDelta.Y * Row;
+				BottomUV = SubImageDelta.Y * (Row + 1);
+			}
+
+			const float MaterialDataX = HasDynamicMaterial ? DynamicMaterialX[ParticleIndex] : 0.f;
+			const float MaterialDataY = HasDynamicMaterial ? DynamicMaterialY[ParticleIndex] : 0.f;
+
+			const FVector2f Corner0 = FastRotate(FVector2f(-ParticleHalfSize.X, -ParticleHalfSize.Y), ParticleRotationSin, ParticleRotationCos);
+			const FVector2f Corner1 = FastRotate(FVector2f(ParticleHalfSize.X, -ParticleHalfSize.Y), ParticleRotationSin, ParticleRotationCos);
+
+			const FVector2f Positions[4] = { ParticlePosition + Corner0, ParticlePosition + Corner1, ParticlePosition - Corner1, ParticlePosition - Corner0 };
+			const float U[4] = { LeftUV, RightUV, LeftUV, RightUV };
+			const float V[4] = { TopUV, TopUV, BottomUV, BottomUV };
+
+			FSlateVertex* Vertices = Params.VertexData + ParticleIndex * 4;
+			
+			for (int i = 0; i < 4; ++i)
+			{
+				Vertices[i].Position = Positions[i];
+				Vertices[i].Color = ParticleColor;
+				Vertices[i].TexCoords[0] = U[i];
+				Vertices[i].TexCoords[1] = V[i];
+				Vertices[i].TexCoords[2] = MaterialDataX;
+				Vertices[i].TexCoords[3] = MaterialDataY;
+			}
+		}
+	}
+
+	FORCEINLINE VectorRegister4Float LoadLanes(const FNiagaraUIFloatStream& Stream, int32 Component, int32 Index)
+	{
+		const float* Data = Stream.GetComponentData(Component);
+		return Stream.IsBound() ? VectorLoad(Data + Index) : VectorLoadFloat1(Data);
+	}
+
+	// Same output as SpriteKernel within float tolerance. Positions, sizes and rotations are computed for four particles at a time,
+	// colors and UVs are resolved per lane while fanning the particles out to their vertices
+	template<uint32 Flags>
+	void SpriteKernelSIMD(const FNiagaraUISpriteKernelParams& Params, int32 StartIndex, int32 EndIndex)
+	{
+		constexpr bool LocalSpace = (Flags & KernelFlag_LocalSpace) != 0;
+		constexpr bool FakeDepth = (Flags & KernelFlag_FakeDepth) != 0;
+		constexpr bool SubImage = (Flags & KernelFlag_SubImage) != 0;
+		constexpr bool HasColor = (Flags & KernelFlag_Color) != 0;
+		constexpr bool HasDynamicMaterial = (Flags & KernelFlag_DynamicMaterial) != 0;
+		constexpr bool Thinning = (Flags & KernelFlag_Thinning) != 0;
+		constexpr ENiagaraUISpriteOrientation Orientation = (ENiagaraUISpriteOrientation)(Flags >> KernelFlag_OrientationShift);
+		constexpr bool Aligned = Orientation == ENiagaraUISpriteOrientation::Velocity || Orientation == ENiagaraUISpriteOrientation::Custom;
+
+		const FVector2f PositionScale = LocalSpace ? Params.ComponentScale * Params.ScaleFactor : FVector2f(Params.ScaleFactor, Params.ScaleFactor);
+		const FVector2f PositionOffset = Params.ParentTopLeft + (LocalSpace ? Params.ComponentOffset : Params.WorldSpaceOffset);
+
+		float WidgetSin, WidgetCos;
+		FMath::SinCos(&WidgetSin, &WidgetCos, FMath::DegreesToRadians(-Params.WidgetRotationAngle));
+
+		const VectorRegister4Float ScaleX = VectorSetFloat1(PositionScale.X);
+		const VectorRegister4Float ScaleY = VectorSetFloat1(PositionScale.Y);
+		const VectorRegister4Float NegativeScaleY = VectorSetFloat1(-PositionScale.Y);
+		const VectorRegister4Float OffsetX = VectorSetFloat1(PositionOffset.X);
+		const VectorRegister4Float OffsetY = VectorSetFloat1(PositionOffset.Y);
+		const VectorRegister4Float WidgetSinLanes = VectorSetFloat1(WidgetSin);
+		const VectorRegister4Float WidgetCosLanes = VectorSetFloat1(WidgetCos);
+		const VectorRegister4Float DepthDistance = VectorSetFloat1(Params.FakeDepthScaleDistance);
+		const VectorRegister4Float DepthScaler = VectorSetFloat1(1.f / Params.FakeDepthScaleDistance);
+		const VectorRegister4Float RotationOffset = VectorSetFloat1(LocalSpace ? -Params.WidgetRotationAngle : 0.f);
+		const VectorRegister4Float DegreesToRadians = VectorSetFloat1(PI / 180.f);
+		const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+		const VectorRegister4Float SmallNumber = VectorSetFloat1(1.e-8f);
+		const VectorRegister4Float MinusOne = VectorSetFloat1(-1.f);
+		const VectorRegister4Float Two = VectorSetFloat1(2.f);
+		const bool SubPixelThinning = Thinning && Params.MinScreenSize > 0.f;
+		const VectorRegister4Float InvMinScreenSize = VectorSetFloat1(SubPixelThinning ? 1.f / Params.MinScreenSize : 0.f);
+
+		const FVector2f SubImageSize = Params.SubImageSize;
+		const FVector2f SubImageDelta = FVector2f::UnitVector / SubImageSize;
+		
+		const FColor ConstantColor = FNiagaraUIColorConversion::ToFColorSRGB(FLinearColor::White, Params.Tint);
+		
+		const float* SubImageData = Params.SubImage.GetComponentData(0);
+		const float* DynamicMaterialX = Params.DynamicMaterial.GetComponentData(0);
+		const float* DynamicMaterialY = Params.DynamicMaterial.GetComponentData(1);
+
+		const FNiagaraUIFloatStream& AlignmentData = Orientation == ENiagaraUISpriteOrientation::Velocity ? Params.Velocity : Params.Alignment;
+
+		int32 ParticleIndex = StartIndex;
+		
+		for (; ParticleIndex + 4 <= EndIndex; ParticleIndex += 4)
+		{
+			VectorRegister4Float PositionX = VectorMultiply(LoadLanes(Params.Position, 0, ParticleIndex), ScaleX);
+			VectorRegister4Float PositionY = VectorMultiply(LoadLanes(Params.Position, 2, ParticleIndex), NegativeScaleY);
+			VectorRegister4Float HalfSizeX = VectorMultiply(VectorMultiply(LoadLanes(Params.Size, 0, ParticleIndex), ScaleX), Half);
+			VectorRegister4Float HalfSizeY = VectorMultiply(VectorMultiply(LoadLanes(Params.Size, 1, ParticleIndex), ScaleY), Half);
+
+			if (LocalSpace)
+			{
+				const VectorRegister4Float RotatedX = VectorSubtract(VectorMultiply(WidgetCosLanes, PositionX), VectorMultiply(WidgetSinLanes, PositionY));
+				PositionY = VectorMultiplyAdd(WidgetCosLanes, PositionY, VectorMultiply(WidgetSinLanes, PositionX));
+				PositionX = RotatedX;
+			}
+
+			PositionX = VectorAdd(PositionX, OffsetX);
+			PositionY = VectorAdd(PositionY, OffsetY);
+
+			if (FakeDepth)
+			{
+				const VectorRegister4Float Depth = VectorMultiply(VectorSubtract(DepthDistance, LoadLanes(Params.Position, 1, ParticleIndex)), DepthScaler);
+				HalfSizeX = VectorMultiply(HalfSizeX, Depth);
+				HalfSizeY = VectorMultiply(HalfSizeY, Depth);
+			}
+
+			// Lanes with coverage below 1 are smaller than the minimum screen size
+			alignas(16) float LaneCoverage[4];
+			
+			if (SubPixelThinning)
+			{
+				const VectorRegister4Float ScreenSize = VectorMultiply(VectorMax(VectorAbs(HalfSizeX), VectorAbs(HalfSizeY)), Two);
+				const VectorRegister4Float Coverage = VectorMin(VectorMultiply(ScreenSize, InvMinScreenSize), VectorOne());
+				VectorStoreAligned(Coverage, LaneCoverage);
+
+				if (Params.ThinSubPixelParticles)
+				{
+					const VectorRegister4Float Enlarge = VectorSelect(VectorCompareGT(Coverage, VectorZero()), VectorDivide(VectorOne(), Coverage), VectorOne());
+					HalfSizeX = VectorMultiply(HalfSizeX, Enlarge);
+					HalfSizeY = VectorMultiply(HalfSizeY, Enlarge);
+				}
+			}
+
+			VectorRegister4Float Sin, Cos;
+			
+			if (Aligned)
+			{
+				const VectorRegister4Float AlignmentX = LoadLanes(AlignmentData, 0, ParticleIndex);
+				const VectorRegister4Float AlignmentY = LoadLanes(AlignmentData, 2, ParticleIndex);
+				const VectorRegister4Float LengthSquared = VectorMultiplyAdd(AlignmentX, AlignmentX, VectorMultiply(AlignmentY, AlignmentY));
+
+				// Zero length alignment normalizes to a zero vector, like GetSafeNormal
+				Cos = VectorSelect(VectorCompareGT(LengthSquared, SmallNumber), VectorMultiply(AlignmentY, VectorReciprocalSqrt(LengthSquared)), VectorZero());
+				const VectorRegister4Float SinSign = VectorSelect(VectorCompareGE(AlignmentX, VectorZero()), VectorOne(), MinusOne);
+				Sin = VectorMultiply(VectorSqrt(VectorMax(VectorSubtract(VectorOne(), VectorMultiply(Cos, Cos)), VectorZero())), SinSign);
+
+				// Rotating by the widget angle through the angle difference identities instead of going through Acos
+				if (LocalSpace)
+				{
+					const VectorRegister4Float LocalSin = VectorSubtract(VectorMultiply(Sin, WidgetCosLanes), VectorMultiply(Cos, VectorNegate(WidgetSinLanes)));
+					Cos = VectorMultiplyAdd(Sin, VectorNegate(WidgetSinLanes), VectorMultiply(Cos, WidgetCosLanes));
+					Sin = LocalSin;
+				}
+			}
+			else if (Orientation == ENiagaraUISpriteOrientation::Rotation)
+			{
+				const VectorRegister4Float Angle = VectorMultiply(VectorAdd(LoadLanes(Params.Rotation, 0, ParticleIndex), RotationOffset), DegreesToRadians);
+				VectorSinCos(&Sin, &Cos, &Angle);
+			}
+			else
+			{
+				Sin = LocalSpace ? WidgetSinLanes : VectorZero();
+				Cos = LocalSpace ? WidgetCosLanes : VectorOne();
+			}
+
+			// Corner 0 is rotated (-HalfSize.X, -HalfSize.Y), corner 1 is rotated (HalfSize.X, -HalfSize.Y), the other two are mirrored
+			const VectorRegister4Float Corner0X = VectorSubtract(VectorMultiply(Sin, HalfSizeY), VectorMultiply(Cos, HalfSizeX));
+			const VectorRegister4Float Corner0Y = VectorNegate(VectorMultiplyAdd(Sin, HalfSizeX, VectorMultiply(Cos, HalfSizeY)));
+			const VectorRegister4Float Corner1X = VectorMultiplyAdd(Cos, HalfSizeX, VectorMultiply(Sin, HalfSizeY));
+			const VectorRegister4Float Corner1Y = VectorSubtract(VectorMultiply(Sin, HalfSizeX), VectorMultiply(Cos, HalfSizeY));
+
+			alignas(16) float VertexX[4][4];
+			alignas(16) float VertexY[4][4];
+			
+			VectorStoreAligned(VectorAdd(PositionX, Corner0X), VertexX[0]);
+			VectorStoreAligned(VectorAdd(PositionY, Corner0Y), VertexY[0]);
+			VectorStoreAligned(VectorAdd(PositionX, Corner1X), VertexX[1]);
+			VectorStoreAligned(VectorAdd(PositionY, Corner1Y), VertexY[1]);
+			VectorStoreAligned(VectorSubtract(PositionX, Corner1X), VertexX[2]);
+			VectorStoreAligned(VectorSubtract(PositionY, Corner1Y), VertexY[2]);
+			VectorStoreAligned(VectorSubtract(PositionX, Corner0X), VertexX[3]);
+			VectorStoreAligned(VectorSubtract(PositionY, Corner0Y), VertexY[3]);
+
+			for (int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				const int32 LaneIndex = ParticleIndex + Lane;
+				FSlateVertex* Vertices = Params.VertexData + LaneIndex * 4;
+
+				float AlphaScale = 1.f;
+
+				if (Thinning && Params.KeepFraction < 1.f && HashParticleIndex(GetThinningKey(Params, LaneIndex) + BudgetHashOffset) >= Params.KeepFraction)
+				{
+					WriteDroppedQuad(Vertices, FVector2f(VertexX[0][Lane], VertexY[0][Lane]));
+					continue;
+				}
+
+				if (SubPixelThinning && LaneCoverage[Lane] < 1.f)
+				{
+					if (!Params.ThinSubPixelParticles || HashParticleIndex(GetThinningKey(Params, LaneIndex)) >= LaneCoverage[Lane])
+					{
+						WriteDroppedQuad(Vertices, FVector2f(VertexX[0][Lane], VertexY[0][Lane]));
+						continue;
+					}
+
+					AlphaScale = LaneCoverage[Lane];
+				}
+
+				FColor ParticleColor = ConstantColor;
+
+				if (HasColor || AlphaScale < 1.f)
+				{
+					FLinearColor ParticleTint = Params.Tint;
+					ParticleTint.A *= AlphaScale;
+					
+					ParticleColor = FNiagaraUIColorConversion::ToFColorSRGB(HasColor ? Params.Color.GetColor(LaneIndex) : FLinearColor::White, ParticleTint);
+				}
+
+				float LeftUV = 0.f;
+				float RightUV = SubImageDelta.X;
+				float TopUV = 0.f;
+				float BottomUV = SubImageDelta.Y;
+
+				if (SubImage)
+				{
+					const float ParticleSubImage = SubImageData[LaneIndex];
+					const int Row = (int)FMath::Floor(ParticleSubImage / SubImageSize.X) % (int)SubImageSize.Y;
+					const int Column = (int)(ParticleSubImage) % (int)(SubImageSize.X);
+
+					LeftUV = SubImageDelta.X * Column;
+					RightUV = SubImageDelta.X * (Column + 1);
+					TopUV = SubImageDelta.Y * Row;
+					BottomUV = SubImageDelta.Y * (Row + 1);
+				}
+				
+				const float MaterialDataX = HasDynamicMaterial ? DynamicMaterialX[LaneIndex] : 0.f;
+				const float MaterialDataY = HasDynamicMaterial ? DynamicMaterialY[LaneIndex] : 0.f;
+				
+				const float U[4] = { LeftUV, RightUV, LeftUV, RightUV };
+				const float V[4] = { TopUV, TopUV, BottomUV, BottomUV };
+
+				for (int i = 0; i < 4; ++i)
+				{
+					Vertices[i].Position = FVector2f(VertexX[i][Lane], VertexY[i][Lane]);
+					Vertices[i].Color = ParticleColor;
+					Vertices[i].TexCoords[0] = U[i];
+					Vertices[i].TexCoords[1] = V[i];
+					Vertices[i].TexCoords[2] = MaterialDataX;
+					Vertices[i].TexCoords[3] = MaterialDataY;
+				}
+			}
+		}
+
+		// Particles that don't fill a whole group
+		if (ParticleIndex < EndIndex)
+			SpriteKernel<Flags>(Params, ParticleIndex, EndIndex);
+	}
+
+	template<uint32... KernelFlags>
+	const FKernelFunction* GetKernelTable(TIntegerSequence<uint32, KernelFlags...>)
+	{
+		static const FKernelFunction KernelTable[] = { &SpriteKernel<KernelFlags>... };
+		return KernelTable;
+	}
+	
+	template<uint32... KernelFlags>
+	const FKernelFunction* GetSIMDKernelTable(TIntegerSequence<uint32, KernelFlags...>)
+	{
+		static const FKernelFunction KernelTable[] = { &SpriteKernelSIMD<KernelFlags>... };
+		return KernelTable;
+	}
+
+	uint32 GetKernelFlags(const FNiagaraUISpriteKernelParams& Params)
+	{
+		uint32 Flags = (uint32)Params.Orientation << KernelFlag_OrientationShift;
+
+		if (Params.LocalSpace)
+			Flags |= KernelFlag_LocalSpace;
+
+		if (Params.FakeDepthScale)
+			Flags |= KernelFlag_FakeDepth;
+
+		if (Params.SubImage.IsBound() && Params.SubImageSize != FVector2f::UnitVector)
+			Flags |= KernelFlag_SubImage;
+
+		if (Params.Color.IsBound())
+			Flags |= KernelFlag_Color;
+
+		if (Params.DynamicMaterial.IsBound())
+			Flags |= KernelFlag_DynamicMaterial;
+
+		if (Params.MinScreenSize > 0.f || Params.KeepFraction < 1.f)
+			Flags |= KernelFlag_Thinning;
+
+		return Flags;
+	}
+	
+	void GenerateVertices(const FNiagaraUISpriteKernelParams& Params, int32 StartIndex, int32 EndIndex)
+	{
+		static const FKernelFunction* KernelTable = GetKernelTable(TMakeIntegerSequence<uint32, NumKernels>());
+		static const FKernelFunction* SIMDKernelTable = GetSIMDKernelTable(TMakeIntegerSequence<uint32, NumKernels>());
+
+		const FKernelFunction* Kernels = NiagaraUICVars::SpriteKernel != 0 ? SIMDKernelTable : KernelTable;
+		Kernels[GetKernelFlags(Params)](Params, StartIndex, EndIndex);
+	}
+
+	int32 BuildSprites(const FNiagaraUISpriteKernelParams& Params, SlateIndex* IndexData, int32 NumSprites, const FSlateRect& CullingRect)
+	{
+		// Culled and thinned out sprites are removed after the vertices are generated
+		const bool CullSprites = CullingRect.IsValid() || Params.MinScreenSize > 0.f || Params.KeepFraction < 1.f;
+	
+		// Index pattern only depends on the particle count, so it's copied from the shared cache and the kernels write vertices only.
+		// With culling, the indices are copied once the number of visible sprites is known
+		const int32 ParallelThreshold = NiagaraUICVars::ParallelSpriteThreshold;
+
+		if (ParallelThreshold > 0 && NumSprites >= ParallelThreshold)
+		{
+			SCOPE_CYCLE_COUNTER(STAT_GenerateSpriteDataParallel);
+
+			// Every particle owns 4 vertices and 6 indices, so the chunks write disjoint ranges. Chunk size is kept a multiple of the SIMD group size
+			const int32 ChunkSize = Align(FMath::Max(NiagaraUICVars::ParallelSpriteChunkSize, 4), 4);
+			const int32 NumChunks = FMath::DivideAndRoundUp(NumSprites, ChunkSize);
+
+			ParallelFor(NumChunks, [&Params, IndexData, ChunkSize, NumSprites, CullSprites](int32 ChunkIndex)
+			{
+				const int32 StartIndex = ChunkIndex * ChunkSize;
+				const int32 EndIndex = FMath::Min(StartIndex + ChunkSize, NumSprites);
+
+				GenerateVertices(Params, StartIndex, EndIndex);
+
+				if (!CullSprites)
+					FNiagaraUISpriteIndexBuffer::CopyIndices(IndexData, StartIndex, EndIndex - StartIndex);
+			});
+		}
+		else
+		{
+			GenerateVertices(Params, 0, NumSprites);
+
+			if (!CullSprites)
+				FNiagaraUISpriteIndexBuffer::CopyIndices(IndexData, NumSprites);
+		}
+
+		if (!CullSprites)
+			return NumSprites;
+		
+		const int32 NumVisibleSprites = NiagaraUICulling::CompactVisibleQuads(Params.VertexData, NumSprites, CullingRect);
+		FNiagaraUISpriteIndexBuffer::CopyIndices(IndexData, NumVisibleSprites);
+		
+		return NumVisibleSprites;
+	}
+
+	// Replaces a bound stream with its values of the picked particles, stored one component after another like the particle buffer
+	static void GatherStream(FNiagaraUIFloatStream& Stream, int32 NumComponents, const int32* Indices, int32 NumIndices)
+	{
+		if (!Stream.IsBound())
+			return;
+
+		float* Data = new(FMemStack::Get()) float[NumIndices * NumComponents];
+
+		for (int32 Component = 0; Component < NumComponents; ++Component)
+		{
+			for (int32 i = 0; i < NumIndices; ++i)
+				Data[Component * NumIndices + i] = Stream.Get(Component, Indices[i]);
+		}
+
+		Stream = FNiagaraUIFloatStream(Data, NumIndices, FNiagaraUIFloatStream::Zeros);
+	}
+
+	int32 CapParticles(FNiagaraUISpriteKernelParams& Params, int32 NumParticles, int32 MaxParticles)
+	{
+		if (MaxParticles <= 0 || NumParticles <= MaxParticles)
+			return NumParticles;
+
+		int32* Indices = new(FMemStack::Get()) int32[NumParticles];
+		int32 NumIndices = 0;
+
+		if (Params.IDIndex)
+		{
+			const float Fraction = (float)MaxParticles / NumParticles;
+
+			for (int32 ParticleIndex = 0; ParticleIndex < NumParticles; ++ParticleIndex)
+			{
+				if (HashParticleIndex(GetThinningKey(Params, ParticleIndex) + CapHashOffset) < Fraction)
+					Indices[NumIndices++] = ParticleIndex;
+			}
+		}
+		else
+		{
+			for (int32 ParticleIndex = 0; ParticleIndex < NumParticles; ++ParticleIndex)
+				Indices[NumIndices++] = ParticleIndex;
+		}
+
+		// Without IDs every particle is a candidate. The hash only keeps MaxParticles on average, either way the ones over the cap are removed by an even stride
+		if (NumIndices > MaxParticles)
+		{
+			for (int32 i = 0; i < MaxParticles; ++i)
+				Indices[i] = Indices[(int32)((int64)i * NumIndices / MaxParticles)];
+
+			NumIndices = MaxParticles;
+		}
+
+		// Streams the orientation doesn't read are dropped rather than gathered
+		if (Params.Orientation != ENiagaraUISpriteOrientation::Rotation)
+			Params.Rotation = FNiagaraUIFloatStream(nullptr, 0, FNiagaraUIFloatStream::Zeros);
+
+		if (Params.Orientation != ENiagaraUISpriteOrientation::Velocity)
+			Params.Velocity = FNiagaraUIFloatStream(nullptr, 0, FNiagaraUIFloatStream::Zeros);
+
+		if (Params.Orientation != ENiagaraUISpriteOrientation::Custom)
+			Params.Alignment = FNiagaraUIFloatStream(nullptr, 0, FNiagaraUIFloatStream::Zeros);
+
+		GatherStream(Params.Position, 3, Indices, NumIndices);
+		GatherStream(Params.Color, 4, Indices, NumIndices);
+		GatherStream(Params.Velocity, 3, Indices, NumIndices);
+		GatherStream(Params.Alignment, 3, Indices, NumIndices);
+		GatherStream(Params.Size, 2, Indices, NumIndices);
+		GatherStream(Params.Rotation, 1, Indices, NumIndices);
+		GatherStream(Params.SubImage, 1, Indices, NumIndices);
+		GatherStream(Params.DynamicMaterial, 4, Indices, NumIndices);
+
+		if (Params.IDIndex)
+		{
+			int32* IDs = new(FMemStack::Get()) int32[NumIndices * 2];
+
+			for (int32 i = 0; i < NumIndices; ++i)
+			{
+				IDs[i] = Params.IDIndex[Indices[i]];
+				IDs[NumIndices + i] = Params.IDAcquireTag[Indices[i]];
+			}
+
+			Params.IDIndex = IDs;
+			Params.IDAcquireTag = IDs + NumIndices;
+		}
+
+		return NumIndices;
+	}
+
+	// Record fields are integers below 2^24 stored as float values rather than bit patterns, so denormal flushing or NaN
+	// canonicalization on the way to the material can't change them
+	FORCEINLINE void WriteInstance(FVector4f& Instance, uint32 X, uint32 Y, uint32 Z, uint32 W)
+	{
+		Instance = FVector4f((float)X, (float)Y, (float)Z, (float)W);
+	}
+
+	// 14 bit positions in 1/4 pixels cover InstancePositionRange in each direction from the origin
+	static constexpr float InstancePositionScale = 4.f;
+	static constexpr int32 InstancePositionBias = 8192;
+
+	// Sub image frame index is stored in 8 bits
+	static constexpr float MaxInstanceSubImages = 256.f;
+
+	// Sizes are stored as 10 bit logarithms, 64 steps per octave from 1/16 to 4096 pixels
+	FORCEINLINE uint32 PackInstanceSize(float Size)
+	{
+		return (uint32)FMath::Clamp(FMath::RoundToInt((FMath::Log2(FMath::Max(Size, 1.e-4f)) + 4.f) * 64.f), 0, 1023);
+	}
+
+	int32 BuildSpriteInstances(const FNiagaraUISpriteKernelParams& Params, FVector4f* InstanceData, int32 NumSprites, const FVector2f Origin, const FSlateRect& CullingRect)
+	{
+		const bool LocalSpace = Params.LocalSpace;
+		const bool Cull = CullingRect.IsValid();
+		const bool Aligned = Params.Orientation == ENiagaraUISpriteOrientation::Velocity || Params.Orientation == ENiagaraUISpriteOrientation::Custom;
+		
+		const FVector2f PositionScale = LocalSpace ? Params.ComponentScale * Params.ScaleFactor : FVector2f(Params.ScaleFactor, Params.ScaleFactor);
+		const FVector2f PositionOffset = Params.ParentTopLeft + (LocalSpace ? Params.ComponentOffset : Params.WorldSpaceOffset);
+
+		float WidgetSin, WidgetCos;
+		FMath::SinCos(&WidgetSin, &WidgetCos, FMath::DegreesToRadians(-Params.WidgetRotationAngle));
+		const float WidgetRotationAngleRadians = LocalSpace ? FMath::DegreesToRadians(Params.WidgetRotationAngle) : 0.f;
+
+		const float FakeDepthScaler = 1.f / Params.FakeDepthScaleDistance;
+		const bool SubImage = Params.SubImage.IsBound() && Params.SubImageSize != FVector2f::UnitVector;
+		const bool Thinning = Params.MinScreenSize > 0.f || Params.KeepFraction < 1.f;
+		
+		const FColor ConstantColor = FNiagaraUIColorConversion::ToFColorSRGB(FLinearColor::White, Params.Tint);
+		const FNiagaraUIFloatStream& AlignmentData = Params.Orientation == ENiagaraUISpriteOrientation::Velocity ? Params.Velocity : Params.Alignment;
+
+		// The records have no room for the dynamic material data or larger flipbooks
+		if (Params.DynamicMaterial.IsBound() || (SubImage && Params.SubImageSize.X * Params.SubImageSize.Y > MaxInstanceSubImages))
+			return INDEX_NONE;
+		
+		int32 NumInstances = 0;
+
+		for (int32 ParticleIndex = 0; ParticleIndex < NumSprites; ++ParticleIndex)
+		{
+			if (Thinning && Params.KeepFraction < 1.f && HashParticleIndex(GetThinningKey(Params, ParticleIndex) + BudgetHashOffset) >= Params.KeepFraction)
+				continue;
+			
+			FVector2f ParticlePosition = FVector2f(Params.Position.Get(0, ParticleIndex), -Params.Position.Get(2, ParticleIndex)) * PositionScale;
+			FVector2f ParticleSize = Params.Size.GetVector2(ParticleIndex) * PositionScale;
+
+			if (LocalSpace)
+				ParticlePosition = FastRotate(ParticlePosition, WidgetSin, WidgetCos);
+
+			ParticlePosition += PositionOffset;
+
+			if (Params.FakeDepthScale)
+				ParticleSize *= (-Params.Position.Get(1, ParticleIndex) + Params.FakeDepthScaleDistance) * FakeDepthScaler;
+
+			float AlphaScale = 1.f;
+
+			if (Params.MinScreenSize > 0.f)
+			{
+				const float Coverage = FMath::Max(FMath::Abs(ParticleSize.X), FMath::Abs(ParticleSize.Y)) / Params.MinScreenSize;
+
+				if (Coverage < 1.f)
+				{
+					if (!Params.ThinSubPixelParticles || HashParticleIndex(GetThinningKey(Params, ParticleIndex)) >= Coverage)
+						continue;
+
+					ParticleSize /= Coverage;
+					AlphaScale = Coverage;
+				}
+			}
+
+			// Bounding circle of the rotated sprite
+			const float Radius = ParticleSize.GetAbs().Size() * 0.5f;
+			const FVector2f RelativePosition = ParticlePosition - Origin;
+			
+			if (Cull && (ParticlePosition.X + Radius < CullingRect.Left || ParticlePosition.X - Radius > CullingRect.Right || ParticlePosition.Y + Radius < CullingRect.Top || ParticlePosition.Y - Radius > CullingRect.Bottom))
+				continue;
+
+			// Dropping visible sprites would make them pop in and out at the edge of the range
+			if (FMath::Abs(RelativePosition.X) > InstancePositionRange || FMath::Abs(RelativePosition.Y) > InstancePositionRange)
+				return INDEX_NONE;
+
+			// Sizes are stored without a sign, mirrored sprites are only drawn correctly by the vertex path
+			if (ParticleSize.X < 0.f || ParticleSize.Y < 0.f)
+				return INDEX_NONE;
+
+			FColor ParticleColor = ConstantColor;
+
+			if (Params.Color.IsBound() || AlphaScale < 1.f)
+			{
+				FLinearColor ParticleTint = Params.Tint;
+				ParticleTint.A *= AlphaScale;
+				
+				ParticleColor = FNiagaraUIColorConversion::ToFColorSRGB(Params.Color.IsBound() ? Params.Color.GetColor(ParticleIndex) : FLinearColor::White, ParticleTint);
+			}
+
+			// Same rotation as the vertex kernels, as an angle in radians
+			float ParticleRotation = LocalSpace ? -WidgetRotationAngleRadians : 0.f;
+
+			if (Aligned)
+			{
+				const FVector2f AlignmentVector = FVector2f(AlignmentData.Get(0, ParticleIndex), AlignmentData.Get(2, ParticleIndex));
+				const float SinSign = AlignmentVector.X >= 0.f ? 1.f : -1.f;
+				
+				ParticleRotation = FMath::Acos(AlignmentVector.GetSafeNormal().Y) * SinSign - WidgetRotationAngleRadians;
+			}
+			else if (Params.Orientation == ENiagaraUISpriteOrientation::Rotation)
+			{
+				ParticleRotation = FMath::DegreesToRadians(Params.Rotation.Get(0, ParticleIndex)) - WidgetRotationAngleRadians;
+			}
+
+			const uint32 PackedX = (uint32)FMath::RoundToInt(RelativePosition.X * InstancePositionScale) + InstancePositionBias;
+			const uint32 PackedY = (uint32)FMath::RoundToInt(RelativePosition.Y * InstancePositionScale) + InstancePositionBias;
+			const uint32 PackedRotation = (uint32)FMath::RoundToInt(ParticleRotation * (256.f / (2.f * PI))) & 0xff;
+			const uint32 PackedSubImage = SubImage ? (uint32)FMath::Clamp(FMath::FloorToInt(Params.SubImage.Get(0, ParticleIndex)), 0, 255) : 0u;
+
+			WriteInstance(InstanceData[NumInstances++],
+				PackedX | (PackInstanceSize(ParticleSize.X) << 14),
+				PackedY | (PackInstanceSize(ParticleSize.Y) << 14),
+				ParticleColor.R | (ParticleColor.G << 8) | (ParticleColor.B << 16),
+				ParticleColor.A | (PackedRotation << 8) | (PackedSubImage << 16));
+		}
+
+		return NumInstances;
+	}
+}
@@ -0,0 +1,123 @@
+// Copyright 2024 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraUIParticleStreams.h"
+#include "Rendering/RenderingCommon.h"
+
+struct FSlateVertex;
+class FSlateRect;
+
+// How the sprite kernels compute the sprite rotation
+enum class ENiagaraUISpriteOrientation : uint8
+{
+	// Rotation attribute is bound
+	Rotation,
+	// Rotation attribute is unbound, so all sprites share the same rotation
+	NoRotation,
+	// Aligned to the velocity
+	Velocity,
+	// Aligned to the custom alignment attribute
+	Custom
+};
+
+// Inputs of the sprite vertex kernels, resolved once per renderer per frame
+struct FNiagaraUISpriteKernelParams
+{
+public:
+	FNiagaraUISpriteKernelParams(const FNiagaraDataBuffer& Buffer, const FNiagaraUISpriteLayout& Layout);
+
+	// All attributes unbound. Streams are assigned by the caller
+	FNiagaraUISpriteKernelParams();
+	
+public:
+	FNiagaraUIFloatStream Position;
+	FNiagaraUIFloatStream Color;
+	FNiagaraUIFloatStream Velocity;
+	FNiagaraUIFloatStream Alignment;
+	FNiagaraUIFloatStream Size;
+	FNiagaraUIFloatStream Rotation;
+	FNiagaraUIFloatStream SubImage;
+	FNiagaraUIFloatStream DynamicMaterial;
+
+	bool LocalSpace = false;
+	bool FakeDepthScale = false;
+	ENiagaraUISpriteOrientation Orientation = ENiagaraUISpriteOrientation::Rotation;
+	
+	float ScaleFactor = 1.f;
+	FVector2f ParentTopLeft = FVector2f::ZeroVector;
+	FLinearColor Tint = FLinearColor::White;
+
+	// Transform of the widget, used by local space emitters. The offset is already scaled by the scale factor
+	FVector2f ComponentScale = FVector2f::UnitVector;
+	FVector2f ComponentOffset = FVector2f::ZeroVector;
+	float WidgetRotationAngle = 0.f;
+
+	// Offset of the widget from the simulation, used by world space emitters of simulations shared by several widgets. Already scaled
+	FVector2f WorldSpaceOffset = FVector2f::ZeroVector;
+
+	float FakeDepthScaleDistance = 1000.f;
+	FVector2f SubImageSize = FVector2f::UnitVector;
+
+	// Sprites smaller than this many pixels are dropped, or kept at this size with a probability matching their coverage. 0 disables it
+	float MinScreenSize = 0.f;
+	bool ThinSubPixelParticles = true;
+
+	// Fraction of the particles drawn when the widget is over its vertex budget. The rest is dropped
+	float KeepFraction = 1.f;
+
+	// Persistent particle IDs, index and acquire tag. Thinning picks particles by their ID, so the same ones stay while the buffer is reordered.
+	// Null picks them by their buffer index
+	const int32* IDIndex = nullptr;
+	const int32* IDAcquireTag = nullptr;
+
+	// Four vertices are written per particle, starting at the particle's index * 4. Dropped particles get all four vertices at the same position
+	FSlateVertex* VertexData = nullptr;
+};
+
+namespace NiagaraUISpriteKernels
+{
+	// Stable pseudo-random value in [0, 1) for the stochastic thinning of particles
+	FORCEINLINE float HashParticleIndex(uint32 Index)
+	{
+		Index ^= Index >> 16;
+		Index *= 0x85ebca6bu;
+		Index ^= Index >> 13;
+		Index *= 0xc2b2ae35u;
+		Index ^= Index >> 16;
+		
+		return (Index >> 8) * (1.f / 16777216.f);
+	}
+
+	// Distance from the origin in pixels an instance record can hold
+	static constexpr float InstancePositionRange = 2047.f;
+
+	/**
+	 *	Fills the vertices of particles [StartIndex, EndIndex) with a kernel specialized for the params' space, depth scale, orientation
+	 *	and the set of bound attributes, so the particle loop doesn't branch on them and skips reads of unbound attributes
+	 */
+	void GenerateVertices(const FNiagaraUISpriteKernelParams& Params, int32 StartIndex, int32 EndIndex);
+
+	/**
+	 *	Generates the vertices and indices of NumSprites sprites, on multiple threads for large counts, and removes the sprites culled by
+	 *	the rect, the min screen size or the keep fraction. Returns the number of sprites left at the start of the buffers
+	 */
+	int32 BuildSprites(const FNiagaraUISpriteKernelParams& Params, SlateIndex* IndexData, int32 NumSprites, const FSlateRect& CullingRect);
+
+	/**
+	 *	Reduces the params to at most MaxParticles particles spread over the whole buffer, for niagaraui.MaxParticlesPerRenderer. With
+	 *	persistent IDs the particles are picked by a hash of their ID, so the same ones stay while others spawn and die, otherwise by an
+	 *	even stride. The bound streams and IDs of the picked particles are gathered on the FMemStack, so the caller needs a mark that
+	 *	outlives the params. Returns the number of particles left
+	 */
+	int32 CapParticles(FNiagaraUISpriteKernelParams& Params, int32 NumParticles, int32 MaxParticles);
+
+	/**
+	 *	Packs one float4 record per visible sprite for the instanced sprite material, see Shaders/Private/NiagaraUIInstancedSprite.ush for
+	 *	the layout. Doesn't use the params' vertex data. Returns the number of records written, or INDEX_NONE if the records can't hold
+	 *	the renderer's sprites, e.g. with dynamic material data or a visible sprite further than InstancePositionRange from Origin,
+	 *	and they have to be generated as vertices instead
+	 */
+	int32 BuildSpriteInstances(const FNiagaraUISpriteKernelParams& Params, FVector4f* InstanceData, int32 NumSprites, const FVector2f Origin, const FSlateRect& CullingRect);
+}
@@ -0,0 +1,363 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "NiagaraUISubsystem.h"
+#include "NiagaraUIComponent.h"
+#include "NiagaraUIActor.h"
+#include "NiagaraUIStats.h"
+#include "NiagaraUIConsoleVariables.h"
+#include "NiagaraSystem.h"
+#include "SNiagaraUISystemWidget.h"
+#include "Engine/World.h"
+#include "Framework/Application/SlateApplication.h"
+
+DECLARE_CYCLE_STAT(TEXT("Subsystem Tick"), STAT_NiagaraUISubsystemTick, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Suspended Components"), STAT_NiagaraUISuspendedComponents, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Components"), STAT_NiagaraUIComponents, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Component Pool Hits"), STAT_NiagaraUIPoolHits, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Component Pool Misses"), STAT_NiagaraUIPoolMisses, STATGROUP_NiagaraUI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Components"), STAT_NiagaraUIPooledComponents, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Solo Components"), STAT_NiagaraUISoloComponents, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shared Simulations"), STAT_NiagaraUISharedSimulations, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Snapshot Render Tasks"), STAT_NiagaraUISnapshotRenderTasks, STATGROUP_NiagaraUI);
+DECLARE_MEMORY_STAT(TEXT("Pooled Component Memory"), STAT_NiagaraUIPooledMemory, STATGROUP_NiagaraUI);
+
+void UNiagaraUISubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (FSlateApplication::IsInitialized())
+		SlatePreTickHandle = FSlateApplication::Get().OnPreTick().AddUObject(this, &UNiagaraUISubsystem::OnSlatePreTick);
+}
+
+void UNiagaraUISubsystem::Deinitialize()
+{
+	if (FSlateApplication::IsInitialized())
+		FSlateApplication::Get().OnPreTick().Remove(SlatePreTickHandle);
+	
+	WaitForAsyncRenderData();
+	ClearPool();
+	
+	SharedSimulations.Empty();
+	Components.Empty();
+	HostActor = nullptr;
+	
+	Super::Deinitialize();
+}
+
+void UNiagaraUISubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NiagaraUISubsystemTick);
+
+	INC_DWORD_STAT_BY(STAT_NiagaraUIComponents, Components.Num());
+	INC_DWORD_STAT_BY(STAT_NiagaraUISharedSimulations, SharedSimulations.Num());
+
+	CleanupPool();
+
+	for (int32 ComponentIndex = Components.Num() - 1; ComponentIndex >= 0; --ComponentIndex)
+	{
+		UNiagaraUIComponent* Component = Components[ComponentIndex].Get();
+
+		if (!Component)
+		{
+			Components.RemoveAtSwap(ComponentIndex);
+			continue;
+		}
+
+		Component->UpdateHiddenState();
+
+		if (Component->IsSuspended())
+			INC_DWORD_STAT(STAT_NiagaraUISuspendedComponents);
+
+		if (Component->GetForceSolo())
+			INC_DWORD_STAT(STAT_NiagaraUISoloComponents);
+	}
+}
+
+TStatId UNiagaraUISubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNiagaraUISubsystem, STATGROUP_Tickables);
+}
+
+void UNiagaraUISubsystem::RegisterComponent(UNiagaraUIComponent* Component)
+{
+	Components.AddUnique(Component);
+}
+
+void UNiagaraUISubsystem::UnregisterComponent(UNiagaraUIComponent* Component)
+{
+	WaitForAsyncRenderData();
+	
+	Components.RemoveSwap(Component);
+}
+
+UNiagaraUIComponent* UNiagaraUISubsystem::AcquireComponent(UNiagaraSystem* NiagaraSystemTemplate, bool AutoActivate, bool ShowDebugSystem, bool TickWhenPaused)
+{
+	if (FNiagaraUIComponentPool* Pool = NiagaraSystemTemplate ? ComponentPools.Find(NiagaraSystemTemplate) : nullptr)
+	{
+		// Most recently released components are the warmest
+		while (Pool->FreeComponents.Num() > 0)
+		{
+			const FNiagaraUIPooledComponent Entry = Pool->FreeComponents.Pop();
+			
+			PooledMemory -= Entry.MemorySize;
+			--NumPooledComponents;
+
+			if (!IsValid(Entry.Component))
+				continue;
+
+			INC_DWORD_STAT(STAT_NiagaraUIPoolHits);
+			SET_MEMORY_STAT(STAT_NiagaraUIPooledMemory, PooledMemory);
+			SET_DWORD_STAT(STAT_NiagaraUIPooledComponents, NumPooledComponents);
+
+			Entry.Component->OnReusedFromPool(AutoActivate, ShowDebugSystem, TickWhenPaused);
+			return Entry.Component;
+		}
+	}
+
+	ANiagaraUIActor* Host = GetHostActor();
+
+	if (!Host)
+		return nullptr;
+
+	INC_DWORD_STAT(STAT_NiagaraUIPoolMisses);
+	SET_MEMORY_STAT(STAT_NiagaraUIPooledMemory, PooledMemory);
+	SET_DWORD_STAT(STAT_NiagaraUIPooledComponents, NumPooledComponents);
+
+	return Host->SpawnNewNiagaraUIComponent(NiagaraSystemTemplate, AutoActivate, ShowDebugSystem, TickWhenPaused);
+}
+
+UNiagaraUIComponent* UNiagaraUISubsystem::AcquireSharedComponent(UNiagaraSystem* NiagaraSystemTemplate, FName SharedSimulationKey, bool AutoActivate, bool ShowDebugSystem, bool TickWhenPaused, bool* OutCreated)
+{
+	if (OutCreated)
+		*OutCreated = false;
+	
+	if (SharedSimulationKey.IsNone() || !NiagaraSystemTemplate)
+	{
+		UNiagaraUIComponent* Component = AcquireComponent(NiagaraSystemTemplate, AutoActivate, ShowDebugSystem, TickWhenPaused);
+
+		if (OutCreated)
+			*OutCreated = Component != nullptr;
+
+		return Component;
+	}
+
+	const TPair<TObjectKey<UNiagaraSystem>, FName> Key(NiagaraSystemTemplate, SharedSimulationKey);
+	FNiagaraUISharedSimulation& SharedSimulation = SharedSimulations.FindOrAdd(Key);
+
+	if (!SharedSimulation.Component.IsValid())
+	{
+		UNiagaraUIComponent* Component = AcquireComponent(NiagaraSystemTemplate, AutoActivate, ShowDebugSystem, TickWhenPaused);
+
+		if (!Component)
+		{
+			SharedSimulations.Remove(Key);
+			return nullptr;
+		}
+
+		Component->SetSharedSimulation(true);
+		SharedSimulation.Component = Component;
+		SharedSimulation.NumUsers = 0;
+
+		if (OutCreated)
+			*OutCreated = true;
+	}
+
+	++SharedSimulation.NumUsers;
+	
+	return SharedSimulation.Component.Get();
+}
+
+void UNiagaraUISubsystem::ReleaseComponent(UNiagaraUIComponent* Component)
+{
+	if (!IsValid(Component) || Component->IsPooled())
+		return;
+
+	WaitForAsyncRenderData();
+
+	if (Component->IsSharedSimulation())
+	{
+		for (auto SharedIt = SharedSimulations.CreateIterator(); SharedIt; ++SharedIt)
+		{
+			if (SharedIt.Value().Component != Component)
+				continue;
+
+			if (--SharedIt.Value().NumUsers > 0)
+				return;
+
+			SharedIt.RemoveCurrent();
+			break;
+		}
+	}
+
+	UNiagaraSystem* NiagaraSystem = Component->GetAsset();
+	UWorld* World = GetWorld();
+
+	if (!NiagaraSystem || !World || World->bIsTearingDown || Component->GetOwner() != HostActor)
+	{
+		Component->DestroyComponent();
+		return;
+	}
+
+	FNiagaraUIComponentPool& Pool = ComponentPools.FindOrAdd(NiagaraSystem);
+
+	if (Pool.FreeComponents.Num() >= NiagaraUICVars::ComponentPoolSize)
+	{
+		Component->DestroyComponent();
+		return;
+	}
+
+	Component->OnReturnedToPool();
+
+	FNiagaraUIPooledComponent& Entry = Pool.FreeComponents.AddDefaulted_GetRef();
+	Entry.Component = Component;
+	Entry.LastUsedTime = World->GetRealTimeSeconds();
+	Entry.MemorySize = Component->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+
+	PooledMemory += Entry.MemorySize;
+	++NumPooledComponents;
+	
+	SET_MEMORY_STAT(STAT_NiagaraUIPooledMemory, PooledMemory);
+	SET_DWORD_STAT(STAT_NiagaraUIPooledComponents, NumPooledComponents);
+}
+
+void UNiagaraUISubsystem::ClearPool()
+{
+	for (TPair<TObjectPtr<UNiagaraSystem>, FNiagaraUIComponentPool>& Pool : ComponentPools)
+	{
+		for (const FNiagaraUIPooledComponent& Entry : Pool.Value.FreeComponents)
+		{
+			if (IsValid(Entry.Component))
+				Entry.Component->DestroyComponent();
+		}
+	}
+
+	ComponentPools.Empty();
+	PooledMemory = 0;
+	NumPooledComponents = 0;
+
+	SET_MEMORY_STAT(STAT_NiagaraUIPooledMemory, PooledMemory);
+	SET_DWORD_STAT(STAT_NiagaraUIPooledComponents, NumPooledComponents);
+}
+
+void UNiagaraUISubsystem::CleanupPool()
+{
+	UWorld* World = GetWorld();
+
+	if (!World || ComponentPools.Num() == 0)
+		return;
+
+	const double CurrentTime = World->GetRealTimeSeconds();
+	const int32 MaxPoolSize = FMath::Max(NiagaraUICVars::ComponentPoolSize, 0);
+
+	for (auto PoolIt = ComponentPools.CreateIterator(); PoolIt; ++PoolIt)
+	{
+		TArray<FNiagaraUIPooledComponent>& FreeComponents = PoolIt.Value().FreeComponents;
+
+		// Entries are sorted by release time, so the oldest are at the front. Also trims pools shrunk by the console variable
+		while (FreeComponents.Num() > 0 && (FreeComponents.Num() > MaxPoolSize || CurrentTime - FreeComponents[0].LastUsedTime > NiagaraUICVars::ComponentPoolCleanupTime))
+		{
+			if (IsValid(FreeComponents[0].Component))
+				FreeComponents[0].Component->DestroyComponent();
+
+			PooledMemory -= FreeComponents[0].MemorySize;
+			--NumPooledComponents;
+			
+			FreeComponents.RemoveAt(0);
+		}
+
+		if (FreeComponents.Num() == 0)
+			PoolIt.RemoveCurrent();
+	}
+
+	SET_MEMORY_STAT(STAT_NiagaraUIPooledMemory, PooledMemory);
+	SET_DWORD_STAT(STAT_NiagaraUIPooledComponents, NumPooledComponents);
+}
+
+void UNiagaraUISubsystem::WaitForAsyncRenderData()
+{
+	if (SnapshotRenderTasks.Num() == 0)
+		return;
+	
+	TRACE_CPUPROFILER_EVENT_SCOPE(UNiagaraUISubsystem::WaitForAsyncRenderData);
+	
+	FTaskGraphInterface::Get().WaitUntilTasksComplete(SnapshotRenderTasks);
+	
+	SnapshotRenderTasks.Reset();
+	SnapshotRenderWidgets.Reset();
+}
+
+void UNiagaraUISubsystem::OnSlatePreTick(float DeltaTime)
+{
+	const UWorld* World = GetWorld();
+
+	if (!World || World->bIsTearingDown || (NiagaraUICVars::AsyncVertexGeneration == 0 && NiagaraUICVars::ParticleSnapshots == 0))
+		return;
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(UNiagaraUISubsystem::LaunchAsyncRenderData);
+	
+	WaitForAsyncRenderData();
+
+	for (const TWeakObjectPtr<UNiagaraUIComponent>& ComponentPtr : Components)
+	{
+		UNiagaraUIComponent* Component = ComponentPtr.Get();
+
+		if (!Component || Component->IsPooled() || Component->IsSuspended())
+			continue;
+
+		TArray<SNiagaraUISystemWidget*, TInlineAllocator<4>> SnapshotWidgets;
+
+		for (const TWeakPtr<SNiagaraUISystemWidget>& WidgetPtr : Component->GetWidgets())
+		{
+			TSharedPtr<SNiagaraUISystemWidget> Widget = WidgetPtr.Pin();
+
+			if (!Widget.IsValid() || !Widget->UsesParticleSnapshot() || !Widget->PrepareAsyncRenderData())
+				continue;
+
+			SnapshotWidgets.Add(Widget.Get());
+			SnapshotRenderWidgets.Add(Widget.ToSharedRef());
+		}
+
+		if (SnapshotWidgets.Num() == 0)
+			continue;
+
+		// One snapshot is shared by all widgets of the component. The tasks only read the copy, so the component can change while they run
+		TSharedRef<const FNiagaraUIParticleSnapshot, ESPMode::ThreadSafe> Snapshot = Component->CaptureParticleSnapshot();
+			
+		FGraphEventRef Task = FFunctionGraphTask::CreateAndDispatchWhenReady([Snapshot, SnapshotWidgets]()
+		{
+			for (SNiagaraUISystemWidget* Widget : SnapshotWidgets)
+				Widget->BuildSnapshotRenderData(*Snapshot);
+		}, TStatId(), nullptr, ENamedThreads::AnyHiPriThreadHiPriTask);
+
+		for (SNiagaraUISystemWidget* Widget : SnapshotWidgets)
+			Widget->SetAsyncRenderTask(Task);
+
+		SnapshotRenderTasks.Add(Task);
+		INC_DWORD_STAT(STAT_NiagaraUISnapshotRenderTasks);
+	}
+}
+
+ANiagaraUIActor* UNiagaraUISubsystem::GetHostActor()
+{
+	if (IsValid(HostActor))
+		return HostActor;
+
+	UWorld* World = GetWorld();
+
+	if (!World || World->bIsTearingDown || !World->PersistentLevel)
+		return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+			
+	HostActor = World->SpawnActor<ANiagaraUIActor>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+	
+	return HostActor;
+}
+
+bool UNiagaraUISubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	// Widget designer previews spawn their particles too
+	return Super::DoesSupportWorldType(WorldType) || WorldType == EWorldType::EditorPreview || WorldType == EWorldType::GamePreview;
+}
@@ -5,9 +5,55 @@
 #include "Materials/MaterialInstanceDynamic.h"
 #include "NiagaraWidgetProperties.h"
 #include "NiagaraUIComponent.h"
+#include "Rendering/DrawElements.h"
+#include "NiagaraUIStats.h"
+#include "NiagaraUIConsoleVariables.h"
+#include "NiagaraUIBudgetSubsystem.h"
+#include "NiagaraUIBakedEffect.h"
+#include "Engine/Engine.h"
+#include "Rendering/SlateRenderer.h"
+#include "NiagaraUISpriteIndexBuffer.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Regenerated Frames"), STAT_NiagaraUIRegeneratedFrames, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Reused Frames"), STAT_NiagaraUIReusedFrames, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Published Frames"), STAT_NiagaraUIAsyncPublishedFrames, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Discarded Frames"), STAT_NiagaraUIAsyncDiscardedFrames, STATGROUP_NiagaraUI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Merged Render Slots"), STAT_NiagaraUIMergedRenderSlots, STATGROUP_NiagaraUI);
+DECLARE_CYCLE_STAT(TEXT("Merge Render Slots"), STAT_MergeRenderSlots, STATGROUP_NiagaraUI);
 
 TMap<TObjectPtr<UMaterialInterface>, TSharedPtr<FSlateMaterialBrush>> SNiagaraUISystemWidget::MaterialBrushMap;
 
+namespace NiagaraUIRenderBuffer
+{
+    // Buffers only grow with some slack, so slowly increasing particle counts don't reallocate every frame
+    template<typename ElementType>
+    void SetNumForFrame(TArray<ElementType>& Buffer, int32 NewNum)
+    {
+        Buffer.Reset();
+
+        if (NewNum > Buffer.Max())
+            Buffer.Reserve(NewNum + NewNum / 4);
+
+        Buffer.AddUninitialized(NewNum);
+    }
+
+    template<typename ElementType>
+    void Trim(TArray<ElementType>& Buffer, int32 NewNum)
+    {
+#if ENGINE_MINOR_VERSION < 4
+        Buffer.SetNum(NewNum, false);
+#else
+        Buffer.SetNum(NewNum, EAllowShrinking::No);
+#endif
+    }
+
+    template<typename ElementType>
+    bool IsOverAllocated(const TArray<ElementType>& Buffer)
+    {
+        return Buffer.Max() > 64 && Buffer.Max() > Buffer.Num() * 2;
+    }
+}
+
 void SNiagaraUISystemWidget::PrivateRegisterAttributes(FSlateAttributeInitializer& AttributeInitializer)
 {
     SLATE_ADD_MEMBER_ATTRIBUTE_DEFINITION_WITH_NAME(AttributeInitializer, "DesiredSize", DesiredSizeAttribute, EInvalidateWidgetReason::Layout);
@@ -22,7 +68,13 @@ void SNiagaraUISystemWidget::Construct(const FArguments& Args)
 
 SNiagaraUISystemWidget::~SNiagaraUISystemWidget()
 {
-    ClearRenderData();
+    if (NiagaraComponent.IsValid())
+        NiagaraComponent->UnregisterWidget(this);
+
+    if (UNiagaraUIBudgetSubsystem* BudgetSubsystem = GEngine ? GEngine->GetEngineSubsystem<UNiagaraUIBudgetSubsystem>() : nullptr)
+        BudgetSubsystem->ReleaseBudget(this);
+    
+    ReleaseRenderData();
     CheckForInvalidBrushes();
 }
 
@@ -30,9 +82,17 @@ int32 SNiagaraUISystemWidget::OnPaint(const FPaintArgs& Args, const FGeometry& A
 {
     TRACE_CPUPROFILER_EVENT_SCOPE(SNiagaraUISystemWidget::OnPaint);
 
-    if (!NiagaraComponent.IsValid())
+    UNiagaraUIComponent* NiagaraUIComponent = NiagaraComponent.Get();
+    UNiagaraUIBakedEffect* PlayedEffect = BakedEffect.Get();
+
+    if ((!NiagaraUIComponent && !PlayedEffect) || NiagaraUICVars::Enable == 0)
         return LayerId;
 
+    SNiagaraUISystemWidget* MutableThis = const_cast<SNiagaraUISystemWidget*>(this);
+
+    // The asynchronous generation writes the back buffer, so it has to finish before the paint reads or regenerates it
+    const bool PublishedAsyncRenderData = MutableThis->PublishAsyncRenderData();
+
     const FSlateLayoutTransform LayoutTransform = AllottedGeometry.GetAccumulatedLayoutTransform();
     
     const float LayoutScale = LayoutTransform.GetScale();
@@ -49,14 +109,132 @@ int32 SNiagaraUISystemWidget::OnPaint(const FPaintArgs& Args, const FGeometry& A
     const float AdditionalAngle = D < 0.f ? 180.f : 0.f;
     const float Angle = FMath::RadiansToDegrees(FMath::Atan(C / D)) + AdditionalAngle;
 
-    FNiagaraUIRenderProperties RenderProperties = FNiagaraUIRenderProperties(LayoutScale, ParentTopLeft, InWidgetStyle.GetColorAndOpacityTint() * ColorAndOpacityAttribute.Get().GetColor(InWidgetStyle));
+    const FSlateRect CullingRect = NiagaraUICVars::CullParticles != 0 ? MyCullingRect : FSlateRect();
 
-    UNiagaraUIComponent* NiagaraUIComponent = NiagaraComponent.Get();
+    FNiagaraUIRenderProperties RenderProperties = FNiagaraUIRenderProperties(LayoutScale, ParentTopLeft, InWidgetStyle.GetColorAndOpacityTint() * ColorAndOpacityAttribute.Get().GetColor(InWidgetStyle), CullingRect);
+
+    // Widgets painted entirely outside of their window count as hidden
+    MutableThis->LastPaintVisible = FSlateRect::DoRectanglesIntersect(AllottedGeometry.GetRenderBoundingRect(), MyCullingRect);
+
+    if (NiagaraUIComponent && !PlayedEffect && LastPaintVisible)
+        NiagaraUIComponent->MarkWidgetVisible();
+
+    // Widgets skipped by the budget keep requesting their last demand, so they get drawn again once there is room for them.
+    // Cached widgets keep drawing their retained vertices between paints, so their request is retained as well
+    UNiagaraUIBudgetSubsystem* BudgetSubsystem = GEngine ? GEngine->GetEngineSubsystem<UNiagaraUIBudgetSubsystem>() : nullptr;
+
+    if (BudgetSubsystem)
+    {
+        const FVector2f PaintSize = FVector2f(AllottedGeometry.GetRenderBoundingRect().GetSize());
+        BudgetSubsystem->RequestBudget(this, WidgetProperties.BudgetPriority, PaintSize.X * PaintSize.Y, VertexDemand, DrawDemand, !IsVolatile());
+
+        RenderProperties.ParticleFraction = BudgetSubsystem->GetGrantedFraction(this);
+        MutableThis->LastGrantedFraction = RenderProperties.ParticleFraction;
+
+        if (RenderProperties.ParticleFraction <= 0.f)
+        {
+            // A skipped cached widget has nothing else to repaint it once its simulation goes idle, so the timer watches the grant
+            if (!IsVolatile())
+                MutableThis->RegisterParticleDataTimer();
+
+            return LayerId;
+        }
+    }
+
+    FNiagaraUIRenderInputs RenderInputs;
+    RenderInputs.Location = Location2D;
+    RenderInputs.Scale = Scale2D.GetVector() / LayoutScale;
+    RenderInputs.Angle = Angle;
+
+    // Particles are placed by this widget's transform rather than the component's, so widgets sharing a simulation each draw it at their own place
+    RenderProperties.WidgetLocation = FVector2f(RenderInputs.Location);
+    RenderProperties.WidgetScale = RenderInputs.Scale;
+    RenderProperties.WidgetAngle = RenderInputs.Angle;
+    RenderInputs.RenderProperties = RenderProperties;
 
-    NiagaraUIComponent->SetTransformationForUIRendering(Location2D, Scale2D.GetVector() / LayoutScale, Angle);
-    NiagaraUIComponent->RenderUI(const_cast<SNiagaraUISystemWidget*>(this), RenderProperties, &WidgetProperties);
+    if (PlayedEffect)
+    {
+        // Playback time starts at the first paint, so effects of widgets created hidden don't start in the middle
+        if (BakedPlaybackActive && BakedPlaybackStartTime < 0.0)
+            MutableThis->BakedPlaybackStartTime = Args.GetCurrentTime();
+
+        RenderInputs.BakedFrameIndex = BakedPlaybackActive ? PlayedEffect->GetFrameIndex(Args.GetCurrentTime() - BakedPlaybackStartTime) : INDEX_NONE;
+    }
+    else
+    {
+        NiagaraUIComponent->SetTransformationForUIRendering(RenderInputs.Location, RenderInputs.Scale, RenderInputs.Angle);
+        RenderInputs.SimulationState = NiagaraUIComponent->GetSimulationState();
+    }
+
+    // Frames generated before the Slate tick are used as long as the widget didn't move since the paint they were generated for
+    const bool UseAsyncRenderData = UsesParticleSnapshot() && !PlayedEffect;
+
+    // Paused games, repeated paints and unrelated Slate repaints would otherwise rebuild identical vertex data
+    bool RegenerateRenderData = RenderDataDirty || !(RenderInputs == LastRenderInputs);
+
+    // Widgets that only advanced their simulation are regenerated every N-th frame, staggered so they don't all land on the same frame
+    const int32 UpdateRateDivisor = NiagaraUICVars::UpdateRateDivisor;
+    
+    if (RegenerateRenderData && !RenderDataDirty && UpdateRateDivisor > 1 && (GFrameCounter + PointerHash(this)) % UpdateRateDivisor != 0)
+    {
+        FNiagaraUIRenderInputs StaticInputs = RenderInputs;
+        StaticInputs.SimulationState = LastRenderInputs.SimulationState;
+        StaticInputs.BakedFrameIndex = LastRenderInputs.BakedFrameIndex;
+        RegenerateRenderData = !(StaticInputs == LastRenderInputs);
+    }
+    
+    if (RegenerateRenderData)
+    {
+        INC_DWORD_STAT(STAT_NiagaraUIRegeneratedFrames);
+
+        if (PublishedAsyncRenderData)
+            INC_DWORD_STAT(STAT_NiagaraUIAsyncDiscardedFrames);
+
+        // Synchronous generation replaces the painted frame in place
+        MutableThis->BuiltRenderData = PaintedRenderData;
+        
+        if (PlayedEffect)
+            PlayedEffect->RenderFrame(MutableThis, RenderInputs.BakedFrameIndex, RenderProperties, &WidgetProperties);
+        else
+            NiagaraUIComponent->RenderUI(MutableThis, RenderProperties, &WidgetProperties);
+        
+        MutableThis->FinishRenderData();
+        MutableThis->ResolveRenderDataBrushes();
+        MutableThis->MergeRenderSlots();
+        MutableThis->UpdateRenderDemand(RenderProperties.ParticleFraction);
+
+        // Generating the render data may rebuild the renderer cache, so the state is captured again afterwards
+        if (!PlayedEffect)
+            RenderInputs.SimulationState = NiagaraUIComponent->GetSimulationState();
+        
+        MutableThis->LastRenderInputs = RenderInputs;
+        MutableThis->RenderDataDirty = false;
+    }
+    else
+    {
+        INC_DWORD_STAT(STAT_NiagaraUIReusedFrames);
+    }
+
+    // The next frame is generated with this paint's geometry, as soon as the simulation ticked
+    MutableThis->AsyncRenderDataRequested = UseAsyncRenderData;
+    MutableThis->AsyncRenderInputs = RenderInputs;
 
-    return SMeshWidget::OnPaint(Args, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled);
+    const FNiagaraUIRenderData& PaintedData = RenderData[PaintedRenderData];
+
+    for (int32 SlotIndex = 0; SlotIndex < PaintedData.NumActiveRenderSlots; ++SlotIndex)
+    {
+        const FNiagaraUIRenderSlot& RenderSlot = PaintedData.RenderSlots[SlotIndex];
+
+        if (!RenderSlot.RenderingResourceHandle.IsValid() || RenderSlot.Merged)
+            continue;
+
+        if (!RenderSlot.Instanced)
+            FSlateDrawElement::MakeCustomVerts(OutDrawElements, LayerId, RenderSlot.RenderingResourceHandle, RenderSlot.VertexData, RenderSlot.IndexData, nullptr, 0, 0);
+        else if (RenderSlot.InstanceBuffer.IsValid())
+            FSlateDrawElement::MakeCustomVerts(OutDrawElements, LayerId, RenderSlot.RenderingResourceHandle, RenderSlot.VertexData, RenderSlot.IndexData, RenderSlot.InstanceBuffer.Get(), 0, RenderSlot.NumInstances);
+    }
+
+    return LayerId;
 }
 
 FVector2D SNiagaraUISystemWidget::ComputeDesiredSize(float LayoutScaleMultiplier) const
@@ -64,37 +242,466 @@ FVector2D SNiagaraUISystemWidget::ComputeDesiredSize(float LayoutScaleMultiplier
     return DesiredSizeAttribute.Get();
 }
 
-void SNiagaraUISystemWidget::AddRenderData(FSlateVertex** OutVertexData, SlateIndex** OutIndexData, UMaterialInterface* Material, int32 NumVertexData, int32 NumIndexData)
+void SNiagaraUISystemWidget::AddRenderData(FSlateVertex** OutVertexData, SlateIndex** OutIndexData, UMaterialInterface* Material, int32 NumVertexData, int32 NumIndexData, bool Thinned)
 {
     if (NumVertexData < 1 || NumIndexData < 1)
         return;
+
+    FNiagaraUIRenderData& BuiltData = RenderData[BuiltRenderData];
+
+    if (BuiltData.NumActiveRenderSlots == BuiltData.RenderSlots.Num())
+        BuiltData.RenderSlots.AddDefaulted();
+    
+    FNiagaraUIRenderSlot& RenderSlot = BuiltData.RenderSlots[BuiltData.NumActiveRenderSlots++];
+
+    NiagaraUIRenderBuffer::SetNumForFrame(RenderSlot.VertexData, NumVertexData);
+    *OutVertexData = RenderSlot.VertexData.GetData();
+    
+    NiagaraUIRenderBuffer::SetNumForFrame(RenderSlot.IndexData, NumIndexData);
+    *OutIndexData = RenderSlot.IndexData.GetData();
+
+    RenderSlot.Material = Material;
+    RenderSlot.Merged = false;
+    RenderSlot.Thinned = Thinned;
+    RenderSlot.Instanced = false;
+    RenderSlot.NumInstances = 0;
+}
+
+void SNiagaraUISystemWidget::AddInstancedRenderData(FVector4f** OutInstanceData, UMaterialInterface* Material, int32 NumInstances, FVector2f Origin, FVector2f SubImageSize)
+{
+    if (NumInstances < 1)
+        return;
+
+    FSlateVertex* VertexData;
+    SlateIndex* IndexData;
+    
+    AddRenderData(&VertexData, &IndexData, Material, FNiagaraUISpriteIndexBuffer::VerticesPerSprite, FNiagaraUISpriteIndexBuffer::IndicesPerSprite, true);
+    FNiagaraUISpriteIndexBuffer::CopyIndices(IndexData, 1);
+
+    // The material moves the corners to the sprites, so all four vertices start at the origin
+    for (int32 Corner = 0; Corner < FNiagaraUISpriteIndexBuffer::VerticesPerSprite; ++Corner)
+    {
+        FSlateVertex& Vertex = VertexData[Corner];
+        FMemory::Memzero(Vertex);
+        
+        Vertex.Position = Origin;
+        Vertex.Color = FColor::White;
+        Vertex.TexCoords[0] = Corner % 2;
+        Vertex.TexCoords[1] = Corner / 2;
+        Vertex.TexCoords[2] = SubImageSize.X;
+        Vertex.TexCoords[3] = SubImageSize.Y;
+    }
+
+    FNiagaraUIRenderData& BuiltData = RenderData[BuiltRenderData];
+    FNiagaraUIRenderSlot& RenderSlot = BuiltData.RenderSlots[BuiltData.NumActiveRenderSlots - 1];
+
+    NiagaraUIRenderBuffer::SetNumForFrame(RenderSlot.InstanceData, NumInstances);
+    *OutInstanceData = RenderSlot.InstanceData.GetData();
+
+    RenderSlot.Instanced = true;
+    RenderSlot.NumInstances = NumInstances;
+}
+
+void SNiagaraUISystemWidget::ResolveRenderDataBrushes()
+{
+    check(IsInGameThread());
+    
+    FNiagaraUIRenderData& BuiltData = RenderData[BuiltRenderData];
+
+    for (int32 SlotIndex = 0; SlotIndex < BuiltData.NumActiveRenderSlots; ++SlotIndex)
+    {
+        FNiagaraUIRenderSlot& RenderSlot = BuiltData.RenderSlots[SlotIndex];
+        UMaterialInterface* MaterialToUse = GetRemappedMaterial(RenderSlot.Material);
+
+        if (!MaterialToUse)
+        {
+            RenderSlot.Brush.Reset();
+            RenderSlot.RenderingResourceHandle = FSlateResourceHandle();
+            RenderSlot.BrushMaterial = nullptr;
+            continue;
+        }
+
+        // The slot is usually reused by the same renderer as last frame, so the brush and its resource handle can be kept
+        if (RenderSlot.BrushMaterial != MaterialToUse || !RenderSlot.Brush.IsValid())
+        {
+            RenderSlot.Brush = CreateSlateMaterialBrush(RenderSlot.Material);
+            RenderSlot.BrushMaterial = MaterialToUse;
+            RenderSlot.RenderingResourceHandle = FSlateResourceHandle();
+        }
+
+        if (!RenderSlot.RenderingResourceHandle.IsValid())
+            RenderSlot.RenderingResourceHandle = FSlateApplication::Get().GetRenderer()->GetResourceHandle(*RenderSlot.Brush);
+
+        if (!RenderSlot.Instanced)
+            continue;
+
+        if (!RenderSlot.InstanceBuffer.IsValid())
+            RenderSlot.InstanceBuffer = FSlateApplication::Get().GetRenderer()->CreateInstanceBuffer(RenderSlot.NumInstances);
+
+        // The buffer takes ownership of the data it's updated with. Handing it an exact copy keeps the slot's staging records and their
+        // slack, so they are built in place again next frame instead of growing a new array
+        if (RenderSlot.InstanceBuffer.IsValid())
+        {
+            FSlateInstanceBufferData UploadData(RenderSlot.InstanceData.GetData(), RenderSlot.NumInstances);
+            RenderSlot.InstanceBuffer->Update(UploadData);
+        }
+    }
+}
+
+void SNiagaraUISystemWidget::MergeRenderSlots()
+{
+    if (NiagaraUICVars::MergeRenderSlots == 0)
+        return;
+
+    SCOPE_CYCLE_COUNTER(STAT_MergeRenderSlots);
+
+    FNiagaraUIRenderData& BuiltData = RenderData[BuiltRenderData];
+    FNiagaraUIRenderSlot* FirstSlot = nullptr;
+
+    for (int32 SlotIndex = 0; SlotIndex < BuiltData.NumActiveRenderSlots; ++SlotIndex)
+    {
+        FNiagaraUIRenderSlot& RenderSlot = BuiltData.RenderSlots[SlotIndex];
+
+        // Slots without a brush aren't drawn, so the slots around them are still consecutive draws
+        if (!RenderSlot.RenderingResourceHandle.IsValid())
+            continue;
+
+        // Merged indices have to stay addressable by SlateIndex
+        const bool CanMerge = FirstSlot && !FirstSlot->Instanced && !RenderSlot.Instanced && FirstSlot->Brush == RenderSlot.Brush
+            && (int64)FirstSlot->VertexData.Num() + RenderSlot.VertexData.Num() <= (int64)TNumericLimits<SlateIndex>::Max() + 1;
+
+        if (!CanMerge)
+        {
+            FirstSlot = &RenderSlot;
+            continue;
+        }
+
+        const SlateIndex BaseVertex = (SlateIndex)FirstSlot->VertexData.Num();
+        const int32 FirstIndex = FirstSlot->IndexData.Num();
+
+        FirstSlot->VertexData.Append(RenderSlot.VertexData);
+        FirstSlot->IndexData.Append(RenderSlot.IndexData);
+
+        for (int32 Index = FirstIndex; Index < FirstSlot->IndexData.Num(); ++Index)
+            FirstSlot->IndexData[Index] += BaseVertex;
+
+        RenderSlot.Merged = true;
+        INC_DWORD_STAT(STAT_NiagaraUIMergedRenderSlots);
+    }
+}
+
+void SNiagaraUISystemWidget::UpdateRenderDemand(float ParticleFraction)
+{
+    const FNiagaraUIRenderData& PaintedData = RenderData[PaintedRenderData];
+    const FNiagaraUIRenderSlot* DrawSlot = nullptr;
+    int32 NumThinnedVertices = 0;
+    int32 NumVertices = 0;
+    int32 NumDraws = 0;
+
+    // Instanced sprites count as the four vertices they would be drawn with otherwise
+    for (int32 SlotIndex = 0; SlotIndex < PaintedData.NumActiveRenderSlots; ++SlotIndex)
+    {
+        const FNiagaraUIRenderSlot& RenderSlot = PaintedData.RenderSlots[SlotIndex];
+        const int32 SlotVertices = RenderSlot.Instanced ? RenderSlot.NumInstances * FNiagaraUISpriteIndexBuffer::VerticesPerSprite : RenderSlot.VertexData.Num();
+
+        (RenderSlot.Thinned ? NumThinnedVertices : NumVertices) += SlotVertices;
+
+        // Merged vertices were appended to the slot that draws them, which may be thinned differently
+        if (RenderSlot.Merged)
+        {
+            if (DrawSlot)
+                (DrawSlot->Thinned ? NumThinnedVertices : NumVertices) -= SlotVertices;
+
+            continue;
+        }
+
+        if (RenderSlot.RenderingResourceHandle.IsValid())
+            DrawSlot = &RenderSlot;
+
+        ++NumDraws;
+    }
+
+    // Only the sprites shrink with the granted fraction, so only they are scaled back up to the full demand
+    VertexDemand = FMath::CeilToInt(NumThinnedVertices / ParticleFraction) + NumVertices;
+    DrawDemand = NumDraws;
+}
+
+bool SNiagaraUISystemWidget::PrepareAsyncRenderData()
+{
+    UNiagaraUIComponent* NiagaraUIComponent = NiagaraComponent.Get();
+
+    // Dirty render data depends on more than the simulation, so it's regenerated by the paint
+    if (!AsyncRenderDataRequested || RenderDataDirty || AsyncRenderTask.IsValid() || !NiagaraUIComponent || BakedEffect.IsValid())
+        return false;
+
+    AsyncRenderInputs.SimulationState = NiagaraUIComponent->GetSimulationState();
+
+    if (AsyncRenderInputs.SimulationState == LastRenderInputs.SimulationState)
+        return false;
+
+    const int32 UpdateRateDivisor = NiagaraUICVars::UpdateRateDivisor;
     
-    FRenderData& NewRenderData = RenderData[RenderData.Add(FRenderData())];
+    if (UpdateRateDivisor > 1 && (GFrameCounter + PointerHash(this)) % UpdateRateDivisor != 0)
+        return false;
 
-    NewRenderData.VertexData.AddUninitialized(NumVertexData);
-    *OutVertexData = &NewRenderData.VertexData[0];
+    BuiltRenderData = 1 - PaintedRenderData;
+    AsyncRenderDataPending = false;
     
-    NewRenderData.IndexData.AddUninitialized(NumIndexData);
-    *OutIndexData = &NewRenderData.IndexData[0];
+    return true;
+}
+
+void SNiagaraUISystemWidget::BuildSnapshotRenderData(const FNiagaraUIParticleSnapshot& Snapshot)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(SNiagaraUISystemWidget::BuildSnapshotRenderData);
+    
+    UNiagaraUIComponent::RenderSnapshot(this, Snapshot, AsyncRenderInputs.RenderProperties, &WidgetProperties);
+
+    AsyncRenderInputs.SimulationState = Snapshot.SimulationState;
+    AsyncRenderDataPending = true;
+}
+
+bool SNiagaraUISystemWidget::UsesParticleSnapshot() const
+{
+    const int32 ParticleSnapshots = NiagaraUICVars::ParticleSnapshots;
+
+    // Asynchronous generation always builds from a copy, as the component can be changed by anything ticking before the paint
+    if (BakedEffect.IsValid())
+        return false;
 
-    if (Material)
+    return NiagaraUICVars::AsyncVertexGeneration != 0 || ParticleSnapshots > 1 || (ParticleSnapshots == 1 && WidgetProperties.UseParticleSnapshot);
+}
+
+bool SNiagaraUISystemWidget::PublishAsyncRenderData()
+{
+    if (AsyncRenderTask.IsValid())
     {
-        NewRenderData.Brush = CreateSlateMaterialBrush(Material);
-        NewRenderData.RenderingResourceHandle = FSlateApplication::Get().GetRenderer()->GetResourceHandle(*NewRenderData.Brush);
+        FTaskGraphInterface::Get().WaitUntilTaskCompletes(AsyncRenderTask);
+        AsyncRenderTask = nullptr;
     }
+
+    if (!AsyncRenderDataPending)
+        return false;
+
+    INC_DWORD_STAT(STAT_NiagaraUIAsyncPublishedFrames);
+
+    AsyncRenderDataPending = false;
+    PaintedRenderData = BuiltRenderData;
+
+    // Releasing slots frees their brushes, so it's done here rather than on the worker
+    FinishRenderData();
+    ResolveRenderDataBrushes();
+    MergeRenderSlots();
+    UpdateRenderDemand(AsyncRenderInputs.RenderProperties.ParticleFraction);
+
+    LastRenderInputs = AsyncRenderInputs;
+    
+    return true;
+}
+
+void SNiagaraUISystemWidget::TrimRenderData(int32 NumVertexData, int32 NumIndexData)
+{
+    FNiagaraUIRenderData& BuiltData = RenderData[BuiltRenderData];
+    
+    if (!ensure(BuiltData.NumActiveRenderSlots > 0))
+        return;
+
+    // The slot stays allocated, so it can be reused by the next frame
+    if (NumVertexData < 1 || NumIndexData < 1)
+    {
+        --BuiltData.NumActiveRenderSlots;
+        return;
+    }
+
+    FNiagaraUIRenderSlot& RenderSlot = BuiltData.RenderSlots[BuiltData.NumActiveRenderSlots - 1];
+
+    NiagaraUIRenderBuffer::Trim(RenderSlot.VertexData, FMath::Min(NumVertexData, RenderSlot.VertexData.Num()));
+    NiagaraUIRenderBuffer::Trim(RenderSlot.IndexData, FMath::Min(NumIndexData, RenderSlot.IndexData.Num()));
 }
 
+void SNiagaraUISystemWidget::TrimInstanceData(int32 NumInstances)
+{
+    FNiagaraUIRenderData& BuiltData = RenderData[BuiltRenderData];
+    
+    if (!ensure(BuiltData.NumActiveRenderSlots > 0) || !ensure(BuiltData.RenderSlots[BuiltData.NumActiveRenderSlots - 1].Instanced))
+        return;
+
+    if (NumInstances < 1)
+    {
+        --BuiltData.NumActiveRenderSlots;
+        return;
+    }
+
+    FNiagaraUIRenderSlot& RenderSlot = BuiltData.RenderSlots[BuiltData.NumActiveRenderSlots - 1];
+
+    RenderSlot.NumInstances = FMath::Min(NumInstances, RenderSlot.InstanceData.Num());
+    NiagaraUIRenderBuffer::Trim(RenderSlot.InstanceData, RenderSlot.NumInstances);
+}
 
 void SNiagaraUISystemWidget::ClearRenderData()
 {
-    RenderData.Empty();
+    RenderData[BuiltRenderData].NumActiveRenderSlots = 0;
 }
 
-TSharedPtr<FSlateMaterialBrush> SNiagaraUISystemWidget::CreateSlateMaterialBrush(UMaterialInterface* Material)
+void SNiagaraUISystemWidget::FinishRenderData()
 {
+    const int32 ShrinkDelay = WidgetProperties.RenderBufferShrinkDelay;
+    
+    if (ShrinkDelay < 1)
+        return;
+
+    TArray<FNiagaraUIRenderSlot>& RenderSlots = RenderData[BuiltRenderData].RenderSlots;
+    const int32 NumActiveRenderSlots = RenderData[BuiltRenderData].NumActiveRenderSlots;
+
+    for (int32 SlotIndex = 0; SlotIndex < RenderSlots.Num(); ++SlotIndex)
+    {
+        FNiagaraUIRenderSlot& RenderSlot = RenderSlots[SlotIndex];
+        
+        const bool IsUnused = SlotIndex >= NumActiveRenderSlots;
+        const bool IsUnderused = IsUnused || NiagaraUIRenderBuffer::IsOverAllocated(RenderSlot.VertexData) || NiagaraUIRenderBuffer::IsOverAllocated(RenderSlot.IndexData);
+
+        RenderSlot.UnderusedFrames = IsUnderused ? RenderSlot.UnderusedFrames + 1 : 0;
+
+        if (RenderSlot.UnderusedFrames < ShrinkDelay || IsUnused)
+            continue;
+
+        RenderSlot.VertexData.Shrink();
+        RenderSlot.IndexData.Shrink();
+        RenderSlot.UnderusedFrames = 0;
+    }
+
+    // Unused slots are released from the back only, so the slot order of the active renderers stays the same
+    int32 NumSlotsToKeep = RenderSlots.Num();
+    
+    while (NumSlotsToKeep > NumActiveRenderSlots && RenderSlots[NumSlotsToKeep - 1].UnderusedFrames >= ShrinkDelay)
+        --NumSlotsToKeep;
+
+    if (NumSlotsToKeep < RenderSlots.Num())
+        RenderSlots.SetNum(NumSlotsToKeep);
+}
+
+void SNiagaraUISystemWidget::ReleaseRenderData()
+{
+    for (FNiagaraUIRenderData& Data : RenderData)
+    {
+        Data.RenderSlots.Empty();
+        Data.NumActiveRenderSlots = 0;
+    }
+
+    AsyncRenderDataPending = false;
+    RenderDataDirty = true;
+}
+
+void SNiagaraUISystemWidget::InvalidateRenderData()
+{
+    RenderDataDirty = true;
+
+    if (!IsVolatile())
+    {
+        Invalidate(EInvalidateWidgetReason::Paint);
+        RegisterParticleDataTimer();
+    }
+}
+
+void SNiagaraUISystemWidget::SetNonVolatile(bool NonVolatile)
+{
+    ForceVolatile(!NonVolatile);
+
+    if (NonVolatile)
+    {
+        RegisterParticleDataTimer();
+    }
+    else if (const TSharedPtr<FActiveTimerHandle> TimerHandle = ParticleDataTimerHandle.Pin())
+    {
+        UnRegisterActiveTimer(TimerHandle.ToSharedRef());
+        ParticleDataTimerHandle.Reset();
+    }
+}
+
+void SNiagaraUISystemWidget::RegisterParticleDataTimer()
+{
+    if (ParticleDataTimerHandle.IsValid())
+        return;
+
+    ParticleDataTimerHandle = RegisterActiveTimer(0.f, FWidgetActiveTimerDelegate::CreateSP(this, &SNiagaraUISystemWidget::CheckParticleDataChanged));
+}
+
+EActiveTimerReturnType SNiagaraUISystemWidget::CheckParticleDataChanged(double InCurrentTime, float InDeltaTime)
+{
+    // Widgets thinned or skipped by the budget are repainted as soon as their grant changes, even when the particles don't
+    const UNiagaraUIBudgetSubsystem* BudgetSubsystem = GEngine ? GEngine->GetEngineSubsystem<UNiagaraUIBudgetSubsystem>() : nullptr;
+    const bool BudgetThrottled = LastGrantedFraction < 1.f;
+
+    if (BudgetThrottled && (BudgetSubsystem ? BudgetSubsystem->GetGrantedFraction(this) : 1.f) != LastGrantedFraction)
+        Invalidate(EInvalidateWidgetReason::Paint);
+
+    if (const UNiagaraUIBakedEffect* PlayedEffect = BakedEffect.Get())
+    {
+        if (IsVolatile())
+        {
+            ParticleDataTimerHandle.Reset();
+            return EActiveTimerReturnType::Stop;
+        }
+
+        const int32 FrameIndex = BakedPlaybackActive && BakedPlaybackStartTime >= 0.0 ? PlayedEffect->GetFrameIndex(InCurrentTime - BakedPlaybackStartTime) : INDEX_NONE;
+
+        if (RenderDataDirty || FrameIndex != LastRenderInputs.BakedFrameIndex)
+            Invalidate(EInvalidateWidgetReason::Paint);
+
+        // Finished or stopped playback won't change until it's played again, which re-registers the timer
+        if (FrameIndex == INDEX_NONE && LastRenderInputs.BakedFrameIndex == INDEX_NONE && !RenderDataDirty && !BudgetThrottled)
+        {
+            ParticleDataTimerHandle.Reset();
+            return EActiveTimerReturnType::Stop;
+        }
+
+        return EActiveTimerReturnType::Continue;
+    }
+    
+    UNiagaraUIComponent* NiagaraUIComponent = NiagaraComponent.Get();
+
+    if (!NiagaraUIComponent || IsVolatile())
+    {
+        ParticleDataTimerHandle.Reset();
+        return EActiveTimerReturnType::Stop;
+    }
+
+    // Cached widgets aren't repainted every frame, so they stay visible as long as their last paint was. Clipped ones are left to suspend
+    if (LastPaintVisible)
+        NiagaraUIComponent->MarkWidgetVisible();
+
+    const FNiagaraUISimulationState SimulationState = NiagaraUIComponent->GetSimulationState();
+
+    if (RenderDataDirty || SimulationState != LastRenderInputs.SimulationState)
+    {
+        // A simulation that ticks without any particles doesn't need to be repainted if nothing was drawn last time either
+        if (RenderDataDirty || RenderData[PaintedRenderData].NumActiveRenderSlots > 0 || NiagaraUIComponent->HasParticlesToRender())
+            Invalidate(EInvalidateWidgetReason::Paint);
+    }
+
+    // The simulation won't change until it's activated again, which re-registers the timer
+    if (!SimulationState.IsActive && !LastRenderInputs.SimulationState.IsActive && !RenderDataDirty && !BudgetThrottled)
+    {
+        ParticleDataTimerHandle.Reset();
+        return EActiveTimerReturnType::Stop;
+    }
+
+    return EActiveTimerReturnType::Continue;
+}
+
+UMaterialInterface* SNiagaraUISystemWidget::GetRemappedMaterial(UMaterialInterface* Material) const
+{
+    if (!Material || !WidgetProperties.MaterialRemapList)
+        return Material;
+    
     const TObjectPtr<UMaterialInterface>* FoundMaterial = WidgetProperties.MaterialRemapList->Find(Material);
     const bool FoundMaterialValid = FoundMaterial && *FoundMaterial != nullptr;
-    UMaterialInterface* MaterialToUse = FoundMaterialValid ? FoundMaterial->Get() : Material;
+    
+    return FoundMaterialValid ? FoundMaterial->Get() : Material;
+}
+
+TSharedPtr<FSlateMaterialBrush> SNiagaraUISystemWidget::CreateSlateMaterialBrush(UMaterialInterface* Material)
+{
+    UMaterialInterface* MaterialToUse = GetRemappedMaterial(Material);
     
     if (MaterialBrushMap.Contains(MaterialToUse))
     {
@@ -134,12 +741,49 @@ void SNiagaraUISystemWidget::SetNiagaraComponentReference(TWeakObjectPtr<UNiagar
     if (!ensure(NiagaraComponentIn != nullptr))
         return;
 
+    if (NiagaraComponent.IsValid() && NiagaraComponent != NiagaraComponentIn)
+        NiagaraComponent->UnregisterWidget(this);
+
     NiagaraComponent = NiagaraComponentIn;
+    NiagaraComponent->RegisterWidget(SharedThis(this));
+    RenderDataDirty = true;
+}
+
+void SNiagaraUISystemWidget::SetBakedEffect(UNiagaraUIBakedEffect* Effect, bool AutoPlay)
+{
+    if (BakedEffect.Get() == Effect)
+        return;
+
+    // The baked effect replaces the simulation, which the owning widget releases
+    if (Effect && NiagaraComponent.IsValid())
+    {
+        NiagaraComponent->UnregisterWidget(this);
+        NiagaraComponent.Reset();
+    }
+
+    BakedEffect = Effect;
+    BakedPlaybackActive = Effect && AutoPlay;
+    BakedPlaybackStartTime = -1.0;
+    InvalidateRenderData();
+}
+
+void SNiagaraUISystemWidget::PlayBakedEffect()
+{
+    BakedPlaybackActive = true;
+    BakedPlaybackStartTime = -1.0;
+    InvalidateRenderData();
+}
+
+void SNiagaraUISystemWidget::StopBakedEffect()
+{
+    BakedPlaybackActive = false;
+    InvalidateRenderData();
 }
 
 void SNiagaraUISystemWidget::SetNiagaraWidgetProperties(FNiagaraWidgetProperties Properties)
 {
     WidgetProperties = Properties;
+    RenderDataDirty = true;
 }
 
 void SNiagaraUISystemWidget::SetDesiredSize(FVector2D NewDesiredSize)
@@ -0,0 +1,125 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "NiagaraUIColorConversion.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace NiagaraUIColorConversionTests
+{
+	// Largest difference of the RGB channels. The table quantizes the input to 12 bits, which moves the result by at most one step
+	static int32 GetMaxChannelDifference(const FColor A, const FColor B)
+	{
+		return FMath::Max3(FMath::Abs(A.R - B.R), FMath::Abs(A.G - B.G), FMath::Abs(A.B - B.B));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraUIColorConversionMatchTest, "NiagaraUIRenderer.ColorConversion.MatchesToFColor",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FNiagaraUIColorConversionMatchTest::RunTest(const FString& Parameters)
+{
+	using namespace NiagaraUIColorConversionTests;
+
+	// Every 8 bit output and the values between them, including out of range ones that get clamped
+	int32 MaxDifference = 0;
+
+	for (int32 Step = -64; Step <= 4096 + 64; ++Step)
+	{
+		const float Value = Step / 4096.f;
+		const FLinearColor Color(Value, Value, Value, Value);
+
+		const FColor Expected = Color.ToFColor(true);
+		const FColor Actual = FNiagaraUIColorConversion::ToFColorSRGB(Color, FLinearColor::White);
+
+		MaxDifference = FMath::Max(MaxDifference, GetMaxChannelDifference(Expected, Actual));
+
+		if (Expected.A != Actual.A)
+		{
+			AddError(FString::Printf(TEXT("Alpha of %f is %d, ToFColor gives %d"), Value, Actual.A, Expected.A));
+			break;
+		}
+	}
+
+	// Random colors with a tint, the way the kernels call it
+	FRandomStream Random(42);
+
+	for (int32 Index = 0; Index < 100000; ++Index)
+	{
+		const FLinearColor Color(Random.FRandRange(-0.1f, 1.5f), Random.FRandRange(-0.1f, 1.5f), Random.FRandRange(-0.1f, 1.5f), Random.FRandRange(-0.1f, 1.5f));
+		const FLinearColor Tint(Random.FRand(), Random.FRand(), Random.FRand(), Random.FRand());
+
+		const FColor Expected = (Color * Tint).ToFColor(true);
+		const FColor Actual = FNiagaraUIColorConversion::ToFColorSRGB(Color, Tint);
+
+		MaxDifference = FMath::Max(MaxDifference, GetMaxChannelDifference(Expected, Actual));
+
+		if (Expected.A != Actual.A)
+		{
+			AddError(FString::Printf(TEXT("Alpha of %s tinted by %s is %d, ToFColor gives %d"), *Color.ToString(), *Tint.ToString(), Actual.A, Expected.A));
+			break;
+		}
+	}
+
+	TestTrue(FString::Printf(TEXT("RGB within one step of ToFColor (largest difference %d)"), MaxDifference), MaxDifference <= 1);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraUIColorConversionBenchmark, "NiagaraUIRenderer.ColorConversion.Benchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FNiagaraUIColorConversionBenchmark::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumParticles = 1000000;
+
+	TArray<FLinearColor> Colors;
+	Colors.SetNumUninitialized(NumParticles);
+
+	FRandomStream Random(42);
+
+	for (FLinearColor& Color : Colors)
+		Color = FLinearColor(Random.FRand(), Random.FRand(), Random.FRand(), Random.FRand());
+
+	const FLinearColor Tint(1.f, 0.8f, 0.6f, 0.9f);
+
+	TArray<FColor> Expected;
+	TArray<FColor> Actual;
+	Expected.SetNumUninitialized(NumParticles);
+	Actual.SetNumUninitialized(NumParticles);
+
+	// Warms up the table, so its one time construction isn't timed
+	FNiagaraUIColorConversion::ToFColorSRGB(FLinearColor::White, Tint);
+
+	double StartTime = FPlatformTime::Seconds();
+
+	for (int32 Index = 0; Index < NumParticles; ++Index)
+		Expected[Index] = (Colors[Index] * Tint).ToFColor(true);
+
+	const double ToFColorTime = FPlatformTime::Seconds() - StartTime;
+	StartTime = FPlatformTime::Seconds();
+
+	for (int32 Index = 0; Index < NumParticles; ++Index)
+		Actual[Index] = FNiagaraUIColorConversion::ToFColorSRGB(Colors[Index], Tint);
+
+	const double TableTime = FPlatformTime::Seconds() - StartTime;
+
+	int32 NumMismatches = 0;
+
+	for (int32 Index = 0; Index < NumParticles; ++Index)
+	{
+		if (NiagaraUIColorConversionTests::GetMaxChannelDifference(Expected[Index], Actual[Index]) > 1 || Expected[Index].A != Actual[Index].A)
+			++NumMismatches;
+	}
+
+	TestEqual(TEXT("Colors differing from ToFColor by more than one step"), NumMismatches, 0);
+
+	AddInfo(FString::Printf(TEXT("Per million particles: ToFColor %.2f ms, lookup table %.2f ms"), ToFColorTime * 1000.0, TableTime * 1000.0));
+
+	return true;
+}
+
+#endif
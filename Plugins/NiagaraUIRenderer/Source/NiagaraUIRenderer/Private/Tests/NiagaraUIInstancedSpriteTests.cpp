@@ -0,0 +1,68 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Layout/SlateRect.h"
+#include "NiagaraUISpriteKernels.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace NiagaraUIInstancedSpriteTests
+{
+	// Position of the record relative to the origin, decoded the same way as NiagaraUIUnpackInstancePosition
+	static FVector2f UnpackPosition(const FVector4f& Instance)
+	{
+		const uint32 PackedX = (uint32)Instance.X;
+		const uint32 PackedY = (uint32)Instance.Y;
+
+		return FVector2f((float)(PackedX & 0x3fff) - 8192.f, (float)(PackedY & 0x3fff) - 8192.f) * 0.25f;
+	}
+
+	// Builds the records of a single world space sprite at the given screen position, relative to an origin at zero
+	static int32 BuildSingleSprite(const FVector2f ScreenPosition, const FSlateRect& CullingRect, FVector4f& OutInstance)
+	{
+		// Component major position streams, screen Y is the negated simulation Z
+		const float PositionData[3] = { ScreenPosition.X, 0.f, -ScreenPosition.Y };
+
+		FNiagaraUISpriteKernelParams Params;
+		Params.Position = FNiagaraUIFloatStream(PositionData, 1, FNiagaraUIFloatStream::Zeros);
+		Params.Orientation = ENiagaraUISpriteOrientation::NoRotation;
+
+		return NiagaraUISpriteKernels::BuildSpriteInstances(Params, &OutInstance, 1, FVector2f::ZeroVector, CullingRect);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraUIInstancedSpritePositionRangeTest, "NiagaraUIRenderer.InstancedSprites.PositionRange",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FNiagaraUIInstancedSpritePositionRangeTest::RunTest(const FString& Parameters)
+{
+	using namespace NiagaraUIInstancedSpriteTests;
+
+	const float Range = NiagaraUISpriteKernels::InstancePositionRange;
+	const FVector2f InsidePositions[] = { FVector2f(Range, -Range), FVector2f(-Range, Range), FVector2f(Range - 0.3f, 12.7f) };
+
+	for (const FVector2f Position : InsidePositions)
+	{
+		FVector4f Instance;
+
+		if (TestEqual(FString::Printf(TEXT("Sprite at %s is packed"), *Position.ToString()), BuildSingleSprite(Position, FSlateRect(), Instance), 1))
+			TestTrue(FString::Printf(TEXT("Sprite at %s keeps its position"), *Position.ToString()), UnpackPosition(Instance).Equals(Position, 0.125f));
+	}
+
+	const FVector2f OutsidePositions[] = { FVector2f(Range + 2.f, 0.f), FVector2f(0.f, -Range - 2.f), FVector2f(10000.f, 10000.f) };
+
+	for (const FVector2f Position : OutsidePositions)
+	{
+		FVector4f Instance;
+		TestEqual(FString::Printf(TEXT("Sprite at %s falls back to vertices"), *Position.ToString()), BuildSingleSprite(Position, FSlateRect(), Instance), (int32)INDEX_NONE);
+	}
+
+	// Sprites out of range that are culled anyway don't need the fallback
+	FVector4f Instance;
+	TestEqual(TEXT("Culled sprite out of range is dropped"), BuildSingleSprite(FVector2f(Range * 2.f, 0.f), FSlateRect(-100.f, -100.f, 100.f, 100.f), Instance), 0);
+
+	return true;
+}
+
+#endif
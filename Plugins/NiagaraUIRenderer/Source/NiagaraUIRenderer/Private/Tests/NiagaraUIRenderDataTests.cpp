@@ -0,0 +1,140 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/MemoryBase.h"
+#include "Math/RandomStream.h"
+#include "Layout/SlateRect.h"
+#include "SNiagaraUISystemWidget.h"
+#include "NiagaraUISpriteKernels.h"
+#include "NiagaraUISpriteIndexBuffer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace NiagaraUIRenderDataTests
+{
+	// Forwards everything to the allocator it replaces and counts the allocations made by the thread that installed it
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* InInner)
+			: Inner(InInner), ThreadId(FPlatformTLS::GetCurrentThreadId())
+		{ }
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->TryMalloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+		int32 GetNumAllocations() const { return NumAllocations; }
+
+	private:
+		void CountAllocation()
+		{
+			if (FPlatformTLS::GetCurrentThreadId() == ThreadId)
+				++NumAllocations;
+		}
+
+	private:
+		FMalloc* Inner;
+		uint32 ThreadId;
+		int32 NumAllocations = 0;
+	};
+
+	// Generates one frame the way the paint does for a system with two sprite renderers, without the brushes that need a Slate renderer
+	static void GenerateFrame(SNiagaraUISystemWidget& Widget, FNiagaraUISpriteKernelParams& Params, int32 NumParticles)
+	{
+		Widget.ClearRenderData();
+
+		for (int32 RendererIndex = 0; RendererIndex < 2; ++RendererIndex)
+		{
+			FSlateVertex* VertexData;
+			SlateIndex* IndexData;
+
+			Widget.AddRenderData(&VertexData, &IndexData, nullptr, NumParticles * FNiagaraUISpriteIndexBuffer::VerticesPerSprite, NumParticles * FNiagaraUISpriteIndexBuffer::IndicesPerSprite, true);
+			Params.VertexData = VertexData;
+
+			const int32 NumVisibleSprites = NiagaraUISpriteKernels::BuildSprites(Params, IndexData, NumParticles, FSlateRect(0.f, 0.f, 512.f, 512.f));
+
+			if (NumVisibleSprites < NumParticles)
+				Widget.TrimRenderData(NumVisibleSprites * FNiagaraUISpriteIndexBuffer::VerticesPerSprite, NumVisibleSprites * FNiagaraUISpriteIndexBuffer::IndicesPerSprite);
+		}
+
+		Widget.FinishRenderData();
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraUIRenderDataAllocationTest, "NiagaraUIRenderer.RenderData.SteadyStateAllocations",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FNiagaraUIRenderDataAllocationTest::RunTest(const FString& Parameters)
+{
+	using namespace NiagaraUIRenderDataTests;
+
+	constexpr int32 MaxParticles = 1000;
+	constexpr int32 NumFrames = 100;
+
+	// Particles spread over twice the culling rect, so the number of visible sprites changes with the particle count
+	TArray<float> PositionData;
+	PositionData.SetNumZeroed(MaxParticles * 3);
+
+	FRandomStream Random(1234);
+
+	for (int32 Index = 0; Index < MaxParticles; ++Index)
+	{
+		PositionData[Index] = Random.FRandRange(-256.f, 768.f);
+		PositionData[MaxParticles * 2 + Index] = -Random.FRandRange(-256.f, 768.f);
+	}
+
+	FNiagaraUISpriteKernelParams Params;
+	Params.Position = FNiagaraUIFloatStream(PositionData.GetData(), MaxParticles, FNiagaraUIFloatStream::Zeros);
+	Params.Orientation = ENiagaraUISpriteOrientation::NoRotation;
+
+	TSharedRef<SNiagaraUISystemWidget> Widget = SNew(SNiagaraUISystemWidget);
+
+	// The first frames grow the slots to the largest particle count
+	for (int32 Frame = 0; Frame < 4; ++Frame)
+		GenerateFrame(*Widget, Params, Frame % 2 == 0 ? MaxParticles : MaxParticles * 3 / 4);
+
+	FMalloc* PreviousMalloc = GMalloc;
+	FCountingMalloc CountingMalloc(PreviousMalloc);
+	GMalloc = &CountingMalloc;
+
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		GenerateFrame(*Widget, Params, Frame % 2 == 0 ? MaxParticles : MaxParticles * 3 / 4);
+
+	GMalloc = PreviousMalloc;
+
+	TestEqual(FString::Printf(TEXT("Allocations in %d steady state frames"), NumFrames), CountingMalloc.GetNumAllocations(), 0);
+
+	return true;
+}
+
+#endif
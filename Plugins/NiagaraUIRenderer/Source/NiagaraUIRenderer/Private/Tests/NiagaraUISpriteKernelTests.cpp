@@ -0,0 +1,291 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/MemStack.h"
+#include "Rendering/DrawElements.h"
+#include "NiagaraUISpriteKernels.h"
+#include "NiagaraUIColorConversion.h"
+#include "NiagaraUIConsoleVariables.h"
+#include "NiagaraUITestParticles.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace NiagaraUISpriteKernelTests
+{
+	// Same hash as the kernels' thinning, so the reference drops the same particles
+	static float HashThinningKey(const FNiagaraUISpriteKernelParams& Params, int32 ParticleIndex, uint32 Offset)
+	{
+		uint32 Key = Params.IDIndex ? (uint32)Params.IDIndex[ParticleIndex] * 0x85ebca77u + (uint32)Params.IDAcquireTag[ParticleIndex] : (uint32)ParticleIndex;
+		Key += Offset;
+
+		Key ^= Key >> 16;
+		Key *= 0x85ebca6bu;
+		Key ^= Key >> 13;
+		Key *= 0xc2b2ae35u;
+		Key ^= Key >> 16;
+
+		return (Key >> 8) * (1.f / 16777216.f);
+	}
+
+	/**
+	 *	Generic sprite expansion branching on the params for every particle, the way the vertices were generated before the kernels
+	 *	were specialized. Reference for the output and the timing of the specialized kernels
+	 */
+	static void GenerateVerticesGeneric(const FNiagaraUISpriteKernelParams& Params, int32 NumParticles)
+	{
+		const bool Aligned = Params.Orientation == ENiagaraUISpriteOrientation::Velocity || Params.Orientation == ENiagaraUISpriteOrientation::Custom;
+		const bool SubImage = Params.SubImage.IsBound() && Params.SubImageSize != FVector2f::UnitVector;
+		const FNiagaraUIFloatStream& AlignmentData = Params.Orientation == ENiagaraUISpriteOrientation::Velocity ? Params.Velocity : Params.Alignment;
+
+		for (int32 ParticleIndex = 0; ParticleIndex < NumParticles; ++ParticleIndex)
+		{
+			FVector2f ParticlePosition = FVector2f(Params.Position.Get(0, ParticleIndex), -Params.Position.Get(2, ParticleIndex));
+			FVector2f ParticleSize = Params.Size.GetVector2(ParticleIndex);
+
+			if (Params.LocalSpace)
+			{
+				ParticlePosition = (ParticlePosition * Params.ComponentScale * Params.ScaleFactor).GetRotated(-Params.WidgetRotationAngle) + Params.ComponentOffset;
+				ParticleSize *= Params.ComponentScale * Params.ScaleFactor;
+			}
+			else
+			{
+				ParticlePosition = ParticlePosition * Params.ScaleFactor + Params.WorldSpaceOffset;
+				ParticleSize *= Params.ScaleFactor;
+			}
+
+			ParticlePosition += Params.ParentTopLeft;
+
+			if (Params.FakeDepthScale)
+				ParticleSize *= (Params.FakeDepthScaleDistance - Params.Position.Get(1, ParticleIndex)) / Params.FakeDepthScaleDistance;
+
+			FSlateVertex* Vertices = Params.VertexData + ParticleIndex * 4;
+			bool Dropped = Params.KeepFraction < 1.f && HashThinningKey(Params, ParticleIndex, 0x9e3779b9u) >= Params.KeepFraction;
+			float AlphaScale = 1.f;
+
+			if (!Dropped && Params.MinScreenSize > 0.f)
+			{
+				const float Coverage = FMath::Max(FMath::Abs(ParticleSize.X), FMath::Abs(ParticleSize.Y)) / Params.MinScreenSize;
+
+				if (Coverage < 1.f)
+				{
+					Dropped = !Params.ThinSubPixelParticles || HashThinningKey(Params, ParticleIndex, 0) >= Coverage;
+					ParticleSize /= Coverage;
+					AlphaScale = Coverage;
+				}
+			}
+
+			if (Dropped)
+			{
+				for (int32 i = 0; i < 4; ++i)
+				{
+					Vertices[i].Position = ParticlePosition;
+					Vertices[i].Color = FColor::Transparent;
+				}
+
+				continue;
+			}
+
+			FLinearColor ParticleTint = Params.Tint;
+			ParticleTint.A *= AlphaScale;
+
+			const FColor ParticleColor = FNiagaraUIColorConversion::ToFColorSRGB(Params.Color.GetColor(ParticleIndex), ParticleTint);
+
+			float ParticleRotation = Params.LocalSpace ? -Params.WidgetRotationAngle : 0.f;
+
+			if (Aligned)
+			{
+				const FVector2f AlignmentVector = FVector2f(AlignmentData.Get(0, ParticleIndex), AlignmentData.Get(2, ParticleIndex));
+				ParticleRotation += FMath::RadiansToDegrees(FMath::Acos(AlignmentVector.GetSafeNormal().Y)) * (AlignmentVector.X >= 0.f ? 1.f : -1.f);
+			}
+			else if (Params.Orientation == ENiagaraUISpriteOrientation::Rotation)
+			{
+				ParticleRotation += Params.Rotation.Get(0, ParticleIndex);
+			}
+
+			FVector2f MinUV = FVector2f::ZeroVector;
+			const FVector2f SubImageDelta = FVector2f::UnitVector / Params.SubImageSize;
+
+			if (SubImage)
+			{
+				const float ParticleSubImage = Params.SubImage.Get(0, ParticleIndex);
+				const int32 Row = (int32)FMath::Floor(ParticleSubImage / Params.SubImageSize.X) % (int32)Params.SubImageSize.Y;
+				const int32 Column = (int32)ParticleSubImage % (int32)Params.SubImageSize.X;
+
+				MinUV = FVector2f(Column, Row) * SubImageDelta;
+			}
+
+			const FVector2f Corners[4] = { FVector2f(-0.5f, -0.5f), FVector2f(0.5f, -0.5f), FVector2f(-0.5f, 0.5f), FVector2f(0.5f, 0.5f) };
+
+			for (int32 i = 0; i < 4; ++i)
+			{
+				const FVector2f UV = MinUV + (Corners[i] + FVector2f(0.5f, 0.5f)) * SubImageDelta;
+
+				Vertices[i].Position = ParticlePosition + (Corners[i] * ParticleSize).GetRotated(ParticleRotation);
+				Vertices[i].Color = ParticleColor;
+				Vertices[i].TexCoords[0] = UV.X;
+				Vertices[i].TexCoords[1] = UV.Y;
+				Vertices[i].TexCoords[2] = Params.DynamicMaterial.Get(0, ParticleIndex);
+				Vertices[i].TexCoords[3] = Params.DynamicMaterial.Get(1, ParticleIndex);
+			}
+		}
+	}
+
+	// Milliseconds per million particles, best of the runs so a context switch doesn't skew it
+	template<typename FunctionType>
+	static double MeasureMillisecondsPerMillion(int32 NumParticles, int32 NumRuns, FunctionType&& Function)
+	{
+		double BestSeconds = TNumericLimits<double>::Max();
+
+		for (int32 Run = 0; Run < NumRuns; ++Run)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			Function();
+			BestSeconds = FMath::Min(BestSeconds, FPlatformTime::Seconds() - StartTime);
+		}
+
+		return BestSeconds * 1000.0 * 1000000.0 / NumParticles;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraUISpriteKernelSpecializationTest, "NiagaraUIRenderer.SpriteKernels.Specializations",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FNiagaraUISpriteKernelSpecializationTest::RunTest(const FString& Parameters)
+{
+	using namespace NiagaraUISpriteKernelTests;
+
+	constexpr int32 NumParticles = 16384;
+	constexpr int32 NumRuns = 4;
+
+	// Scalar kernels only, the SIMD ones are compared against them by their own test
+	TGuardValue<int32> KernelGuard(NiagaraUICVars::SpriteKernel, 0);
+
+	const FNiagaraUITestParticles Particles(NumParticles, 7);
+
+	TArray<FSlateVertex> ExpectedVertices;
+	TArray<FSlateVertex> Vertices;
+	ExpectedVertices.SetNumUninitialized(NumParticles * 4);
+	Vertices.SetNumUninitialized(NumParticles * 4);
+
+	double TotalGenericTime = 0.0;
+	double TotalSpecializedTime = 0.0;
+
+	for (int32 Combination = 0; Combination < FNiagaraUITestKernelSetup::NumCombinations; ++Combination)
+	{
+		const FNiagaraUITestKernelSetup Setup = FNiagaraUITestKernelSetup::FromCombination(Combination);
+		FNiagaraUISpriteKernelParams Params = Particles.MakeParams(Setup);
+
+		// Dropped quads only get positions and colors, the rest would be left over from the previous combination
+		FMemory::Memzero(ExpectedVertices.GetData(), ExpectedVertices.Num() * sizeof(FSlateVertex));
+		FMemory::Memzero(Vertices.GetData(), Vertices.Num() * sizeof(FSlateVertex));
+
+		Params.VertexData = ExpectedVertices.GetData();
+		const double GenericTime = MeasureMillisecondsPerMillion(NumParticles, NumRuns, [&Params]() { GenerateVerticesGeneric(Params, NumParticles); });
+
+		Params.VertexData = Vertices.GetData();
+		const double SpecializedTime = MeasureMillisecondsPerMillion(NumParticles, NumRuns, [&Params]() { NiagaraUISpriteKernels::GenerateVertices(Params, 0, NumParticles); });
+
+		TotalGenericTime += GenericTime;
+		TotalSpecializedTime += SpecializedTime;
+
+		const int32 Mismatch = NiagaraUITestParticles::FindMismatch(ExpectedVertices, Vertices, 0.01f, 1.e-4f, 1);
+
+		if (Mismatch != INDEX_NONE)
+		{
+			AddError(FString::Printf(TEXT("Vertex %d differs from the generic path (%s): expected %s %s, got %s %s"), Mismatch, *Setup.ToString(),
+				*FVector2f(ExpectedVertices[Mismatch].Position).ToString(), *ExpectedVertices[Mismatch].Color.ToString(),
+				*FVector2f(Vertices[Mismatch].Position).ToString(), *Vertices[Mismatch].Color.ToString()));
+		}
+
+		AddInfo(FString::Printf(TEXT("%s: generic %.2f ms, specialized %.2f ms per million particles"), *Setup.ToString(), GenericTime, SpecializedTime));
+	}
+
+	AddInfo(FString::Printf(TEXT("All combinations: generic %.2f ms, specialized %.2f ms per million particles"),
+		TotalGenericTime / FNiagaraUITestKernelSetup::NumCombinations, TotalSpecializedTime / FNiagaraUITestKernelSetup::NumCombinations));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraUISpriteParticleCapTest, "NiagaraUIRenderer.SpriteKernels.ParticleCap",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FNiagaraUISpriteParticleCapTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumParticles = 10000;
+	constexpr int32 MaxParticles = 1000;
+
+	FMemMark Mark(FMemStack::Get());
+
+	// Position X is the buffer index, so the mean of the capped positions shows which part of the buffer they came from
+	TArray<float> PositionData;
+	PositionData.SetNumZeroed(NumParticles * 3);
+
+	for (int32 Index = 0; Index < NumParticles; ++Index)
+		PositionData[Index] = Index;
+
+	auto GetMeanIndex = [](const FNiagaraUISpriteKernelParams& Params, int32 Count)
+	{
+		double Sum = 0.0;
+
+		for (int32 Index = 0; Index < Count; ++Index)
+			Sum += Params.Position.Get(0, Index);
+
+		return Sum / FMath::Max(Count, 1);
+	};
+
+	FNiagaraUISpriteKernelParams StrideParams;
+	StrideParams.Position = FNiagaraUIFloatStream(PositionData.GetData(), NumParticles, FNiagaraUIFloatStream::Zeros);
+
+	const int32 NumStrided = NiagaraUISpriteKernels::CapParticles(StrideParams, NumParticles, MaxParticles);
+	TestEqual(TEXT("Particles left without IDs"), NumStrided, MaxParticles);
+	TestTrue(TEXT("Particles without IDs are picked from the whole buffer"), FMath::IsNearlyEqual(GetMeanIndex(StrideParams, NumStrided), NumParticles * 0.5, NumParticles * 0.01));
+
+	// Same particles with IDs, once in the original order and once reversed, like after the buffer was compacted differently
+	const FNiagaraUITestParticles Particles(NumParticles, 3);
+
+	TArray<int32> ReversedIDs;
+	TArray<float> ReversedPositions;
+	ReversedIDs.SetNumUninitialized(NumParticles * 2);
+	ReversedPositions.SetNumZeroed(NumParticles * 3);
+
+	for (int32 Index = 0; Index < NumParticles; ++Index)
+	{
+		ReversedIDs[Index] = Particles.IDIndex[NumParticles - 1 - Index];
+		ReversedIDs[NumParticles + Index] = Particles.IDAcquireTag[NumParticles - 1 - Index];
+		ReversedPositions[Index] = NumParticles - 1 - Index;
+	}
+
+	FNiagaraUISpriteKernelParams IDParams;
+	IDParams.Position = FNiagaraUIFloatStream(PositionData.GetData(), NumParticles, FNiagaraUIFloatStream::Zeros);
+	IDParams.IDIndex = Particles.IDIndex.GetData();
+	IDParams.IDAcquireTag = Particles.IDAcquireTag.GetData();
+
+	FNiagaraUISpriteKernelParams ReversedParams;
+	ReversedParams.Position = FNiagaraUIFloatStream(ReversedPositions.GetData(), NumParticles, FNiagaraUIFloatStream::Zeros);
+	ReversedParams.IDIndex = ReversedIDs.GetData();
+	ReversedParams.IDAcquireTag = ReversedIDs.GetData() + NumParticles;
+
+	const int32 NumPicked = NiagaraUISpriteKernels::CapParticles(IDParams, NumParticles, MaxParticles);
+	const int32 NumReversedPicked = NiagaraUISpriteKernels::CapParticles(ReversedParams, NumParticles, MaxParticles);
+
+	TestTrue(TEXT("Particles left with IDs"), NumPicked <= MaxParticles && NumPicked > MaxParticles * 9 / 10);
+	TestTrue(TEXT("Particles with IDs are picked from the whole buffer"), FMath::IsNearlyEqual(GetMeanIndex(IDParams, NumPicked), NumParticles * 0.5, NumParticles * 0.05));
+
+	TSet<int32> PickedIDs;
+
+	for (int32 Index = 0; Index < NumPicked; ++Index)
+		PickedIDs.Add(IDParams.IDIndex[Index]);
+
+	int32 NumSamePicked = 0;
+
+	for (int32 Index = 0; Index < NumReversedPicked; ++Index)
+		NumSamePicked += PickedIDs.Contains(ReversedParams.IDIndex[Index]) ? 1 : 0;
+
+	TestTrue(FString::Printf(TEXT("Particles with IDs are picked regardless of their buffer order (%d of %d)"), NumSamePicked, NumPicked), NumSamePicked >= NumPicked * 9 / 10);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,71 @@
+// Copyright 2024 - Michal Smoleň
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Rendering/DrawElements.h"
+#include "NiagaraUISpriteKernels.h"
+#include "NiagaraUIConsoleVariables.h"
+#include "NiagaraUITestParticles.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNiagaraUISpriteSIMDTest, "NiagaraUIRenderer.SpriteKernels.SIMDMatchesScalar",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FNiagaraUISpriteSIMDTest::RunTest(const FString& Parameters)
+{
+	// Not a multiple of the SIMD group size, so the scalar tail of the SIMD kernels runs too
+	constexpr int32 NumParticles = 4099;
+
+	const FNiagaraUITestParticles Particles(NumParticles, 11);
+
+	TArray<FSlateVertex> ScalarVertices;
+	TArray<FSlateVertex> SIMDVertices;
+	ScalarVertices.SetNumUninitialized(NumParticles * 4);
+	SIMDVertices.SetNumUninitialized(NumParticles * 4);
+
+	for (int32 Combination = 0; Combination < FNiagaraUITestKernelSetup::NumCombinations; ++Combination)
+	{
+		const FNiagaraUITestKernelSetup Setup = FNiagaraUITestKernelSetup::FromCombination(Combination);
+		FNiagaraUISpriteKernelParams Params = Particles.MakeParams(Setup);
+
+		FMemory::Memzero(ScalarVertices.GetData(), ScalarVertices.Num() * sizeof(FSlateVertex));
+		FMemory::Memzero(SIMDVertices.GetData(), SIMDVertices.Num() * sizeof(FSlateVertex));
+
+		{
+			TGuardValue<int32> KernelGuard(NiagaraUICVars::SpriteKernel, 0);
+			Params.VertexData = ScalarVertices.GetData();
+			NiagaraUISpriteKernels::GenerateVertices(Params, 0, NumParticles);
+		}
+
+		{
+			TGuardValue<int32> KernelGuard(NiagaraUICVars::SpriteKernel, 1);
+			Params.VertexData = SIMDVertices.GetData();
+			NiagaraUISpriteKernels::GenerateVertices(Params, 0, NumParticles);
+		}
+
+		for (int32 ParticleIndex = 0; ParticleIndex < NumParticles; ++ParticleIndex)
+		{
+			const FSlateVertex* Expected = ScalarVertices.GetData() + ParticleIndex * 4;
+			const FSlateVertex* Actual = SIMDVertices.GetData() + ParticleIndex * 4;
+
+			// Both paths collapse dropped quads, just not to the same point, and these are removed before drawing
+			const bool ExpectedDropped = NiagaraUITestParticles::IsDroppedQuad(Expected);
+			bool Matches = ExpectedDropped == NiagaraUITestParticles::IsDroppedQuad(Actual);
+
+			for (int32 i = 0; i < 4 && Matches && !ExpectedDropped; ++i)
+				Matches = NiagaraUITestParticles::VerticesMatch(Expected[i], Actual[i], 0.01f, 1.e-4f, 1);
+
+			if (!Matches)
+			{
+				AddError(FString::Printf(TEXT("Particle %d differs between the scalar and SIMD kernels (%s): scalar %s %s, SIMD %s %s"), ParticleIndex, *Setup.ToString(),
+					*FVector2f(Expected[0].Position).ToString(), *Expected[0].Color.ToString(), *FVector2f(Actual[0].Position).ToString(), *Actual[0].Color.ToString()));
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif
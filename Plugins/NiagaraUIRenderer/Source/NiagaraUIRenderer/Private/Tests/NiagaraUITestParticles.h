@@ -0,0 +1,195 @@
+// Copyright 2024 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "Rendering/DrawElements.h"
+#include "NiagaraUISpriteKernels.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Sprite kernel inputs of one test case. Combinations are numbered like the kernel flags, the orientation in the highest bits
+struct FNiagaraUITestKernelSetup
+{
+public:
+	static constexpr int32 NumCombinations = 4 << 6;
+
+	static FNiagaraUITestKernelSetup FromCombination(int32 Combination)
+	{
+		FNiagaraUITestKernelSetup Setup;
+		Setup.LocalSpace = (Combination & (1 << 0)) != 0;
+		Setup.FakeDepth = (Combination & (1 << 1)) != 0;
+		Setup.SubImage = (Combination & (1 << 2)) != 0;
+		Setup.Color = (Combination & (1 << 3)) != 0;
+		Setup.DynamicMaterial = (Combination & (1 << 4)) != 0;
+		Setup.Thinning = (Combination & (1 << 5)) != 0;
+		Setup.Orientation = (ENiagaraUISpriteOrientation)(Combination >> 6);
+
+		return Setup;
+	}
+
+	FString ToString() const
+	{
+		return FString::Printf(TEXT("LocalSpace %d, FakeDepth %d, SubImage %d, Color %d, DynamicMaterial %d, Thinning %d, Orientation %d"),
+			LocalSpace, FakeDepth, SubImage, Color, DynamicMaterial, Thinning, (int32)Orientation);
+	}
+
+public:
+	bool LocalSpace = false;
+	bool FakeDepth = false;
+	bool SubImage = false;
+	bool Color = false;
+	bool DynamicMaterial = false;
+	bool Thinning = false;
+	ENiagaraUISpriteOrientation Orientation = ENiagaraUISpriteOrientation::Rotation;
+};
+
+// Random sprite particles for the kernel tests, every attribute stored as component major streams like a particle buffer
+struct FNiagaraUITestParticles
+{
+public:
+	FNiagaraUITestParticles(int32 InNumParticles, int32 Seed)
+		: NumParticles(InNumParticles)
+	{
+		FRandomStream Random(Seed);
+
+		auto Fill = [this, &Random](TArray<float>& Stream, int32 NumComponents, float Min, float Max)
+		{
+			Stream.SetNumUninitialized(NumParticles * NumComponents);
+
+			for (float& Value : Stream)
+				Value = Random.FRandRange(Min, Max);
+		};
+
+		Fill(Position, 3, -300.f, 300.f);
+		Fill(Color, 4, 0.f, 1.5f);
+		Fill(Velocity, 3, -100.f, 100.f);
+		Fill(Alignment, 3, -1.f, 1.f);
+		Fill(Size, 2, 0.5f, 24.f);
+		Fill(Rotation, 1, -360.f, 360.f);
+		Fill(SubImage, 1, 0.f, 16.f);
+		Fill(DynamicMaterial, 4, 0.f, 1.f);
+
+		// Persistent IDs in a different order than the buffer, like after particles died and were compacted
+		IDIndex.SetNumUninitialized(NumParticles);
+		IDAcquireTag.SetNumUninitialized(NumParticles);
+
+		for (int32 Index = 0; Index < NumParticles; ++Index)
+		{
+			IDIndex[Index] = Index;
+			IDAcquireTag[Index] = Random.RandRange(0, 1000);
+		}
+
+		for (int32 Index = NumParticles - 1; Index > 0; --Index)
+			IDIndex.Swap(Index, Random.RandRange(0, Index));
+	}
+
+	// Params reading the streams the setup binds, with a widget transform that isn't the identity
+	FNiagaraUISpriteKernelParams MakeParams(const FNiagaraUITestKernelSetup& Setup) const
+	{
+		FNiagaraUISpriteKernelParams Params;
+		Params.Position = GetStream(Position, FNiagaraUIFloatStream::Zeros);
+		Params.Size = GetStream(Size, FNiagaraUIFloatStream::Ones);
+		Params.Velocity = GetStream(Velocity, FNiagaraUIFloatStream::Zeros);
+		Params.Alignment = GetStream(Alignment, FNiagaraUIFloatStream::Zeros);
+
+		if (Setup.Orientation == ENiagaraUISpriteOrientation::Rotation)
+			Params.Rotation = GetStream(Rotation, FNiagaraUIFloatStream::Zeros);
+
+		if (Setup.Color)
+			Params.Color = GetStream(Color, FNiagaraUIFloatStream::Ones);
+
+		if (Setup.SubImage)
+		{
+			Params.SubImage = GetStream(SubImage, FNiagaraUIFloatStream::Zeros);
+			Params.SubImageSize = FVector2f(4.f, 4.f);
+		}
+
+		if (Setup.DynamicMaterial)
+			Params.DynamicMaterial = GetStream(DynamicMaterial, FNiagaraUIFloatStream::Zeros);
+
+		Params.LocalSpace = Setup.LocalSpace;
+		Params.FakeDepthScale = Setup.FakeDepth;
+		Params.FakeDepthScaleDistance = 500.f;
+		Params.Orientation = Setup.Orientation;
+
+		Params.ScaleFactor = 1.5f;
+		Params.ParentTopLeft = FVector2f(10.f, 20.f);
+		Params.Tint = FLinearColor(1.f, 0.8f, 0.6f, 0.9f);
+		Params.ComponentScale = FVector2f(1.2f, 0.9f);
+		Params.ComponentOffset = FVector2f(200.f, 150.f);
+		Params.WidgetRotationAngle = 30.f;
+		Params.WorldSpaceOffset = FVector2f(50.f, -25.f);
+
+		// Sizes go down to less than a pixel, so some sprites are thinned and some are enlarged
+		if (Setup.Thinning)
+		{
+			Params.MinScreenSize = 4.f;
+			Params.KeepFraction = 0.75f;
+		}
+
+		Params.IDIndex = IDIndex.GetData();
+		Params.IDAcquireTag = IDAcquireTag.GetData();
+
+		return Params;
+	}
+
+private:
+	FNiagaraUIFloatStream GetStream(const TArray<float>& Stream, const float* DefaultValue) const
+	{
+		return FNiagaraUIFloatStream(Stream.GetData(), NumParticles, DefaultValue);
+	}
+
+public:
+	int32 NumParticles;
+
+	TArray<float> Position;
+	TArray<float> Color;
+	TArray<float> Velocity;
+	TArray<float> Alignment;
+	TArray<float> Size;
+	TArray<float> Rotation;
+	TArray<float> SubImage;
+	TArray<float> DynamicMaterial;
+	TArray<int32> IDIndex;
+	TArray<int32> IDAcquireTag;
+};
+
+namespace NiagaraUITestParticles
+{
+	// Whether the vertices match within the tolerances, colors per channel
+	inline bool VerticesMatch(const FSlateVertex& A, const FSlateVertex& B, float PositionTolerance, float UVTolerance, int32 ColorTolerance)
+	{
+		const bool PositionMatches = FVector2f(A.Position).Equals(FVector2f(B.Position), PositionTolerance);
+		const bool ColorMatches = FMath::Abs(A.Color.R - B.Color.R) <= ColorTolerance && FMath::Abs(A.Color.G - B.Color.G) <= ColorTolerance
+			&& FMath::Abs(A.Color.B - B.Color.B) <= ColorTolerance && FMath::Abs(A.Color.A - B.Color.A) <= ColorTolerance;
+
+		bool UVsMatch = true;
+
+		for (int32 Component = 0; Component < 4; ++Component)
+			UVsMatch &= FMath::IsNearlyEqual(A.TexCoords[Component], B.TexCoords[Component], UVTolerance);
+
+		return PositionMatches && ColorMatches && UVsMatch;
+	}
+
+	// Compares two vertex buffers, returns the index of the first vertex that differs by more than the tolerances or INDEX_NONE
+	inline int32 FindMismatch(const TArray<FSlateVertex>& Expected, const TArray<FSlateVertex>& Actual, float PositionTolerance, float UVTolerance, int32 ColorTolerance)
+	{
+		for (int32 Index = 0; Index < Expected.Num(); ++Index)
+		{
+			if (!VerticesMatch(Expected[Index], Actual[Index], PositionTolerance, UVTolerance, ColorTolerance))
+				return Index;
+		}
+
+		return INDEX_NONE;
+	}
+
+	// Dropped particles get all four vertices at one point, kept ones always have an area
+	inline bool IsDroppedQuad(const FSlateVertex* Vertices)
+	{
+		return Vertices[0].Position == Vertices[1].Position && Vertices[0].Position == Vertices[2].Position && Vertices[0].Position == Vertices[3].Position;
+	}
+}
+
+#endif
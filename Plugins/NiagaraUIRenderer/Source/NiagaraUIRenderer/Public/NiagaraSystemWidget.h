@@ -4,14 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "NiagaraWidgetProperties.h"
+#include "NiagaraUIComponent.h"
 #include "Components/Widget.h"
 #include "NiagaraSystemWidget.generated.h"
 
 class SNiagaraUISystemWidget;
 class UMaterialInterface;
 class UNiagaraSystem;
-class ANiagaraUIActor;
 class UNiagaraUIComponent;
+class UNiagaraUIBakedEffect;
 
 /**
  The Niagara System Widget allows to render niagara particle system directly into the UI. Only sprite and ribbon CPU particles are supported.
@@ -39,8 +40,13 @@ public:
 private:
 	void InitializeNiagaraUI();
 
+	void ReleaseNiagaraComponent();
+
+	// The simulation and the widget properties may still be read by the asynchronous vertex generation until the widgets are painted
+	void WaitForAsyncRenderData() const;
+
 public:
-	// Activate Niagara System with option to reset the simulation
+	// Activate Niagara System with option to reset the simulation. A shared simulation is never reset, as that would restart it for every widget
 	UFUNCTION(BlueprintCallable, Category = "Niagara UI Renderer")
 	void ActivateSystem(bool Reset);
 
@@ -56,7 +62,12 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Niagara UI Renderer")
 	void UpdateNiagaraSystemReference(class UNiagaraSystem* NewNiagaraSystem);
 
-	// Updates Tick When Paused - Should be this particle system updated even when the game is paused? Note that this will reset the particle simulation
+	// Plays the baked effect instead of simulating the Niagara System. Set to null to simulate the system again
+	UFUNCTION(BlueprintCallable, Category = "Niagara UI Renderer")
+	void UpdateBakedEffect(UNiagaraUIBakedEffect* NewBakedEffect);
+
+	// Updates Tick When Paused - Should be this particle system updated even when the game is paused? Note that this will reset the particle simulation.
+	// Ignored by widgets that don't configure their shared simulation
 	UFUNCTION(BlueprintCallable, Category = "Niagara UI Renderer")
 	void UpdateTickWhenPaused(bool NewTickWhenPaused);
 
@@ -102,10 +113,20 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Niagara UI Renderer")
 	TMap<TObjectPtr<UMaterialInterface>, TObjectPtr<UMaterialInterface>> MaterialRemapList;
 
+	// Pre-recorded particle frames played back instead of the Niagara System. Baked effects don't need a world or a simulation, only sprite renderers are recorded
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Niagara UI Renderer", BlueprintSetter = UpdateBakedEffect)
+	TObjectPtr<UNiagaraUIBakedEffect> BakedEffect;
+
 	// Should be this particle system automatically activated?
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer")
 	bool AutoActivate = true;
 
+	// Widgets with the same Niagara System and non-empty key render a single shared simulation, each at its own geometry and tint. Leave empty for a simulation per widget.
+	// The simulation is configured by the widget that created it: Tick When Paused, Simulation Rate and the hidden policy of the other widgets are ignored,
+	// Activate System doesn't reset it and any widget's Deactivate System stops it for all of them. It's suspended only once none of the widgets is visible
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer")
+	FName SharedSimulationKey;
+
 	// Should be this particle system updated even when the game is paused?
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Niagara UI Renderer", BlueprintSetter = UpdateTickWhenPaused)
 	bool TickWhenPaused = false;
@@ -138,6 +159,49 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay)
 	bool DisableWarnings = false;
 
+	// Allow Slate to cache this widget when invalidation is enabled. The widget then repaints only on frames when the particle data changed, so inactive systems cost nothing
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay)
+	bool NonVolatile = false;
+
+	// Number of frames the widget's vertex and index buffers can stay over-allocated before their memory is released. 0 keeps them at their high-water mark, so steady state rendering never allocates
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay, meta = (ClampMin = 0))
+	int32 RenderBufferShrinkDelay = 0;
+
+	// Sprites and ribbon segments smaller than this many pixels are treated by the Sub Pixel Mode, so the vertex count scales with the screen resolution. 0 disables it
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay, meta = (ClampMin = 0.f, UIMax = 8.f))
+	float MinParticleScreenSize = 0.f;
+
+	// What happens to sprites and whole ribbons smaller than the Min Particle Screen Size. Thin segments of wider ribbons are widened to it with their alpha scaled down,
+	// short ones merged into the next segment
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay, meta = (EditCondition = "MinParticleScreenSize > 0"))
+	ENiagaraUISubPixelMode SubPixelMode = ENiagaraUISubPixelMode::Thin;
+
+	// Widgets with higher priority get their share of the global vertex and draw budget (niagaraui.VertexBudget, niagaraui.DrawBudget) first. Widgets that don't fit get thinned out or skipped
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay)
+	int32 BudgetPriority = 0;
+
+	// Rate in Hz the simulation is stepped at, with the particle positions interpolated in between at the display rate. Interpolation requires the emitters to have persistent IDs. Widgets sharing a simulation use the rate of the one that created it. 0 simulates every frame
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay, meta = (ClampMin = 0.f, UIMax = 60.f))
+	float SimulationRate = 0.f;
+
+	// Copy the particles before Slate ticks and build the vertices from the copy on a worker thread, so the game thread only pays for the copy. Used when niagaraui.ParticleSnapshots is 1
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay)
+	bool UseParticleSnapshot = false;
+
+	// Upload one 16 byte record per sprite instead of four vertices. The sprite materials have to expand the records, create them with Create Instanced Niagara UI Material.
+	// Sprites of other materials and renderers with dynamic material parameters, which the records can't hold, are still drawn with vertices.
+	// Rotation is stored in 256 steps of about 1.4 degrees, so slowly rotating sprites visibly step
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay)
+	bool UseInstancedSprites = false;
+
+	// What happens to the simulation while the widget isn't painted or lies entirely outside of its window
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay)
+	ENiagaraUIHiddenPolicy HiddenPolicy = ENiagaraUIHiddenPolicy::KeepSimulating;
+
+	// Number of frames the widget has to stay hidden before the hidden policy is applied
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay, meta = (ClampMin = 1, EditCondition = "HiddenPolicy != ENiagaraUIHiddenPolicy::KeepSimulating"))
+	int32 HiddenFramesToSuspend = 10;
+
 	// Should the system restart simulation when a property is changed
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara UI Renderer", AdvancedDisplay)
 	bool RestartSimulationOnPropertyChange = true;
@@ -145,9 +209,9 @@ public:
 private:
 	TSharedPtr<SNiagaraUISystemWidget> NiagaraSlateWidget;
 
-	UPROPERTY()
-	TObjectPtr<ANiagaraUIActor> NiagaraActor;
-
 	UPROPERTY()
 	TObjectPtr<UNiagaraUIComponent> NiagaraComponent;
+
+	// Set for unshared components and for the widget that created its shared simulation. Only this widget applies its simulation settings
+	bool ConfiguresSimulation = false;
 };
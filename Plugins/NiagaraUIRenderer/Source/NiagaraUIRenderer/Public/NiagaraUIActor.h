@@ -9,7 +9,8 @@
 class UNiagaraSystem;
 class UNiagaraUIComponent;
 
-UCLASS()
+// Hosts the UI particle components of a world. Spawned once per world by UNiagaraUISubsystem
+UCLASS(NotPlaceable, Transient)
 class ANiagaraUIActor : public AActor
 {
 	GENERATED_BODY()
@@ -0,0 +1,157 @@
+// Copyright 2024 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "UObject/SoftObjectPtr.h"
+#include "NiagaraUIBakedEffect.generated.h"
+
+class UMaterialInterface;
+class UNiagaraSystem;
+class SNiagaraUISystemWidget;
+struct FNiagaraUIRenderProperties;
+struct FNiagaraWidgetProperties;
+struct FNiagaraUISpriteKernelParams;
+
+UENUM()
+enum class ENiagaraUIBakeQuantization : uint8
+{
+	// Full precision
+	Float32,
+	// Every attribute component is stored as 16 bits between its minimum and maximum in the frame
+	Bits16,
+	// Every attribute component is stored as 8 bits between its minimum and maximum in the frame. Usually enough for small widgets
+	Bits8
+};
+
+// Sprite attributes stored in a baked frame, in the order they are encoded
+enum class ENiagaraUIBakedStream : uint8
+{
+	Position,
+	Color,
+	Size,
+	Rotation,
+	SubImage,
+	// Velocity for velocity aligned sprites, custom alignment otherwise
+	Alignment,
+	DynamicMaterial,
+	Num
+};
+
+// Particles of one sprite renderer in one frame
+USTRUCT()
+struct FNiagaraUIBakedFrame
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+	int32 NumParticles = 0;
+
+	// Minimum and step of every quantized attribute component
+	UPROPERTY()
+	TArray<FVector2f> Ranges;
+
+	UPROPERTY()
+	TArray<uint8> Data;
+};
+
+USTRUCT()
+struct FNiagaraUIBakedSpriteRenderer
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(VisibleAnywhere, Category = "Baked Effect")
+	TObjectPtr<UMaterialInterface> Material;
+
+	UPROPERTY()
+	FVector2f SubImageSize = FVector2f::UnitVector;
+
+	UPROPERTY()
+	bool LocalSpace = true;
+
+	UPROPERTY()
+	uint8 Orientation = 0;
+
+	// Bit per ENiagaraUIBakedStream bound in the source emitter
+	UPROPERTY()
+	uint8 StreamMask = 0;
+
+	UPROPERTY()
+	TArray<FNiagaraUIBakedFrame> Frames;
+};
+
+/**
+ * Sprite particles of a Niagara System recorded frame by frame. Played back by the Niagara System Widget without any world, actor or simulation
+ */
+UCLASS(BlueprintType)
+class NIAGARAUIRENDERER_API UNiagaraUIBakedEffect : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	// Returns the frame shown Time seconds after the playback started, or INDEX_NONE once a non-looping effect finished
+	int32 GetFrameIndex(double Time) const;
+
+	int32 GetNumFrames() const { return NumFrames; }
+
+	// Adds the frame's sprites to the widget's render data, the same way UNiagaraUIComponent::RenderUI does for a simulation
+	void RenderFrame(SNiagaraUISystemWidget* NiagaraWidget, int32 FrameIndex, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties) const;
+
+	// Memory held by the baked particle data
+	SIZE_T GetBakedDataSize() const;
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
+#if WITH_EDITOR
+	// Clears the frames before the effect is baked again
+	void BeginBake();
+
+	// Stores the sprites of one renderer in the given frame. Renderers are identified by their index in the recording component's renderer table
+	void AddSpriteFrame(int32 FrameIndex, int32 RendererIndex, UMaterialInterface* Material, FVector2f SubImageSize, bool LocalSpace, const FNiagaraUISpriteKernelParams& Particles, int32 NumParticles);
+
+	void EndBake(int32 NumBakedFrames);
+#endif
+
+public:
+#if WITH_EDITORONLY_DATA
+	// System the effect is baked from
+	UPROPERTY(EditAnywhere, Category = "Bake")
+	TSoftObjectPtr<UNiagaraSystem> SourceSystem;
+#endif
+
+	UPROPERTY(EditAnywhere, Category = "Bake", meta = (ClampMin = 1.f, UIMax = 60.f))
+	float FrameRate = 30.f;
+
+	UPROPERTY(EditAnywhere, Category = "Bake", meta = (ClampMin = 0.f))
+	float Duration = 2.f;
+
+	// Seconds simulated before the first frame is recorded, so loops don't start with an empty system
+	UPROPERTY(EditAnywhere, Category = "Bake", meta = (ClampMin = 0.f))
+	float WarmupTime = 0.f;
+
+	UPROPERTY(EditAnywhere, Category = "Bake")
+	ENiagaraUIBakeQuantization Quantization = ENiagaraUIBakeQuantization::Bits16;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Playback")
+	bool Loop = true;
+
+	UPROPERTY(VisibleAnywhere, Category = "Stats")
+	int32 NumFrames = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Stats")
+	int32 MaxParticles = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Stats")
+	int64 BakedDataSize = 0;
+
+private:
+	// Quantization the frames were encoded with. Changing Quantization takes effect after the next bake
+	UPROPERTY()
+	ENiagaraUIBakeQuantization BakedQuantization = ENiagaraUIBakeQuantization::Float32;
+	
+	UPROPERTY()
+	TArray<FNiagaraUIBakedSpriteRenderer> SpriteRenderers;
+};
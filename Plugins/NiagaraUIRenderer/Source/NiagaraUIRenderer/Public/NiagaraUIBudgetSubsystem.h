@@ -0,0 +1,62 @@
+// Copyright 2024 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "NiagaraUIBudgetSubsystem.generated.h"
+
+class SNiagaraUISystemWidget;
+
+/**
+ * Shares a project-wide vertex and draw call budget between all Niagara UI widgets.
+ * Widgets request their full vertex and draw counts every paint, and at the start of the next frame the budget is handed out
+ * by priority and on-screen area. Widgets that don't fit get only a fraction of their sprites or are skipped entirely.
+ * Requests of cached widgets are retained until they're painted again, as Slate keeps drawing their last frame meanwhile.
+ */
+UCLASS()
+class NIAGARAUIRENDERER_API UNiagaraUIBudgetSubsystem : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Returns the fraction of particles the widget can draw this frame. 0 means the widget should be skipped
+	float GetGrantedFraction(const SNiagaraUISystemWidget* Widget) const;
+
+	// Registers the vertex and draw counts the widget would need to draw all of its particles. Retained requests stay until the next one
+	// of the widget or ReleaseBudget, the others only count for the next frame
+	void RequestBudget(const SNiagaraUISystemWidget* Widget, int32 Priority, float ScreenArea, int32 NumVertices, int32 NumDraws, bool Retained);
+
+	// Drops the widget's request and grant. Called when the widget is destroyed
+	void ReleaseBudget(const SNiagaraUISystemWidget* Widget);
+
+private:
+	void OnBeginFrame();
+
+	// Removes the requests that only counted for the frame just handed out
+	void ReleaseFrameRequests();
+	
+private:
+	struct FBudgetRequest
+	{
+		const SNiagaraUISystemWidget* Widget = nullptr;
+		int32 Priority = 0;
+		float ScreenArea = 0.f;
+		int32 NumVertices = 0;
+		int32 NumDraws = 0;
+		bool Retained = false;
+	};
+
+	// Requests of the frame being painted and the retained requests of cached widgets, one per widget
+	TMap<const SNiagaraUISystemWidget*, FBudgetRequest> Requests;
+
+	// Fractions granted from last frame's requests. Widgets without a grant draw everything
+	TMap<const SNiagaraUISystemWidget*, float> GrantedFractions;
+
+	FDelegateHandle BeginFrameHandle;
+
+	double LastOverBudgetLogTime = 0.0;
+};
@@ -5,23 +5,201 @@
 #include "CoreMinimal.h"
 #include "NiagaraComponent.h"
 #include "NiagaraWidgetProperties.h"
+#include "NiagaraUIParticleStreams.h"
+#include "Layout/SlateRect.h"
 
 #include "NiagaraUIComponent.generated.h"
 
 class SNiagaraUISystemWidget;
 class FNiagaraEmitterInstance;
+class FNiagaraSystemInstance;
+class UNiagaraSpriteRendererProperties;
+class UNiagaraRibbonRendererProperties;
+class UNiagaraUIBakedEffect;
+class UMaterialInterface;
 
 struct FNiagaraUIRenderProperties
 {
 public:
-	FNiagaraUIRenderProperties(float InScaleFactor, FVector2f InParentTopLeft, FLinearColor InTint)
-		: ScaleFactor(InScaleFactor), ParentTopLeft(InParentTopLeft), Tint(InTint)
+	FNiagaraUIRenderProperties(float InScaleFactor, FVector2f InParentTopLeft, FLinearColor InTint, FSlateRect InCullingRect = FSlateRect())
+		: ScaleFactor(InScaleFactor), ParentTopLeft(InParentTopLeft), Tint(InTint), CullingRect(InCullingRect)
 		{ }
+
+	bool operator==(const FNiagaraUIRenderProperties& Other) const
+	{
+		return ScaleFactor == Other.ScaleFactor && ParentTopLeft == Other.ParentTopLeft && Tint == Other.Tint && CullingRect == Other.CullingRect && ParticleFraction == Other.ParticleFraction
+			&& WidgetLocation == Other.WidgetLocation && WidgetScale == Other.WidgetScale && WidgetAngle == Other.WidgetAngle;
+	}
 	
 public:
 	float ScaleFactor;
 	FVector2f ParentTopLeft;
 	FLinearColor Tint;
+
+	// Particles entirely outside of this rect are not emitted. Invalid rect disables the culling
+	FSlateRect CullingRect;
+
+	// Fraction of the sprites granted by the budget subsystem
+	float ParticleFraction = 1.f;
+
+	// Transform of the widget being rendered, relative to ParentTopLeft and unscaled. Simulations shared by several widgets are drawn at each widget's own transform
+	FVector2f WidgetLocation = FVector2f::ZeroVector;
+	FVector2f WidgetScale = FVector2f::UnitVector;
+	float WidgetAngle = 0.f;
+};
+
+// Identifies the simulation state the particle data comes from. Changes whenever the system ticks, resets or gets (de)activated
+struct FNiagaraUISimulationState
+{
+public:
+	bool operator==(const FNiagaraUISimulationState& Other) const
+	{
+		return SystemInstance == Other.SystemInstance && TickCount == Other.TickCount && Age == Other.Age && IsActive == Other.IsActive && RendererCacheDirty == Other.RendererCacheDirty
+			&& InterpolationAlpha == Other.InterpolationAlpha;
+	}
+
+	bool operator!=(const FNiagaraUISimulationState& Other) const
+	{
+		return !(*this == Other);
+	}
+	
+public:
+	const FNiagaraSystemInstance* SystemInstance = nullptr;
+	int32 TickCount = INDEX_NONE;
+	float Age = -1.f;
+	bool IsActive = false;
+	bool RendererCacheDirty = true;
+
+	// Position between the previous and the current step of a reduced rate simulation. Changes every frame while it's running
+	float InterpolationAlpha = 1.f;
+};
+
+// Sprite or ribbon renderer resolved from the system, cached so the paint path doesn't need to gather, sort and cast renderers every frame
+struct FNiagaraUIRendererEntry
+{
+public:
+	enum class EType : uint8
+	{
+		Sprite,
+		Ribbon
+	};
+	
+public:
+	EType Type = EType::Sprite;
+	int32 EmitterIndex = INDEX_NONE;
+	int32 SortOrderHint = 0;
+	
+	// Weak, as the component doesn't keep the renderers alive. A stale renderer invalidates the table
+	TWeakObjectPtr<UNiagaraSpriteRendererProperties> SpriteRenderer;
+	TWeakObjectPtr<UNiagaraRibbonRendererProperties> RibbonRenderer;
+
+	// Attribute layouts are resolved together with the table, which is rebuilt whenever the emitters are recompiled
+	FNiagaraUISpriteLayout SpriteLayout;
+	FNiagaraUIRibbonLayout RibbonLayout;
+
+	// Persistent particle ID, bound only for emitters that require persistent IDs
+	FNiagaraUIInt32Attribute ParticleID;
+
+	// Positions of the previous step of a reduced rate simulation, indexed by the particle ID index
+	TArray<FVector3f> PreviousPositions;
+	TArray<int32> PreviousAcquireTags;
+};
+
+// UV distribution of a ribbon renderer, copied so ribbons can be built without reading the renderer properties
+struct FNiagaraUIRibbonUVSettings
+{
+public:
+	bool TiledU0 = false;
+	float U0TilingLength = 1.f;
+	bool TiledU1 = false;
+	float U1TilingLength = 1.f;
+};
+
+// Link order and ribbon IDs of ribbon particles, copied out of the particle buffer so the ribbons can be gathered on any thread
+struct FNiagaraUIRibbonLinkData
+{
+public:
+	// Only one is filled, depending on the type of the link order attribute. Float orders link ascending, integer ones descending
+	TArray<float> LinkOrderFloat;
+	TArray<int32> LinkOrderInt32;
+
+	// Full ribbon ID of every particle, empty if the emitter draws a single ribbon
+	TArray<FNiagaraID> RibbonIDs;
+};
+
+// Particles of one renderer copied out of the simulation
+struct FNiagaraUISnapshotRenderer
+{
+public:
+	FNiagaraUIRendererEntry::EType Type = FNiagaraUIRendererEntry::EType::Sprite;
+	UMaterialInterface* Material = nullptr;
+	bool LocalSpace = false;
+	int32 NumParticles = 0;
+
+	// Every copied attribute component is a stream of NumParticles floats. Unbound attributes have no offset and read their default value
+	TArray<float> Data;
+	int32 Position = INDEX_NONE;
+	int32 Color = INDEX_NONE;
+	// Sprite size or ribbon width
+	int32 Size = INDEX_NONE;
+	int32 Rotation = INDEX_NONE;
+	int32 SubImage = INDEX_NONE;
+	// Velocity of velocity aligned sprites or the custom alignment
+	int32 Alignment = INDEX_NONE;
+	int32 DynamicMaterial = INDEX_NONE;
+
+	// Sprites only. Orientation is the ENiagaraUISpriteOrientation of the kernels
+	uint8 Orientation = 0;
+	bool InstancedMaterial = false;
+	FVector2f SubImageSize = FVector2f::UnitVector;
+
+	// ID index of every particle followed by their acquire tags, empty if the emitter has no persistent IDs
+	TArray<int32> ParticleIDs;
+
+	// Positions of the previous step of a reduced rate simulation, indexed by the ID index. Empty if there's nothing to interpolate
+	TArray<FVector3f> PreviousPositions;
+	TArray<int32> PreviousAcquireTags;
+
+	// Ribbons only. The particles are split into ribbons and sorted by their link order when the snapshot is rendered
+	FNiagaraUIRibbonUVSettings RibbonUVSettings;
+	FNiagaraUIRibbonLinkData RibbonLinkData;
+};
+
+/**
+ *	Copy of the particles of all renderers, taken on the game thread before Slate ticks. Vertices are built from it on a worker while the simulation moves on.
+ *	Only the bound streams are copied, the ribbons are gathered and the particles interpolated and capped by the worker
+ */
+struct FNiagaraUIParticleSnapshot
+{
+public:
+	FNiagaraUISimulationState SimulationState;
+	FVector SimulationLocation = FVector::ZeroVector;
+	TArray<FNiagaraUISnapshotRenderer> Renderers;
+
+	// niagaraui.MaxParticlesPerRenderer when the snapshot was taken
+	int32 MaxParticlesPerRenderer = 0;
+};
+
+// What happens to the simulation while the widget showing it isn't visible
+UENUM(BlueprintType)
+enum class ENiagaraUIHiddenPolicy : uint8
+{
+	// The simulation keeps running, only the vertex generation is skipped
+	KeepSimulating,
+	// The simulation is paused and continues where it left off once the widget is visible again
+	Pause,
+	// The simulation is stopped and restarted from the beginning once the widget is visible again
+	ResetOnShow
+};
+
+// What happens to particles smaller than the widget's minimum particle screen size
+UENUM(BlueprintType)
+enum class ENiagaraUISubPixelMode : uint8
+{
+	// Small particles are not drawn
+	Drop,
+	// Small particles are drawn at the minimum size with a probability matching their size, with their alpha scaled down to keep the overall coverage
+	Thin
 };
 
 /**
@@ -42,13 +220,98 @@ public:
 
 	void RenderUI(SNiagaraUISystemWidget* NiagaraWidget, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties);
 
-	void AddSpriteRendererData(SNiagaraUISystemWidget* NiagaraWidget, TSharedRef<const FNiagaraEmitterInstance> EmitterInst,
-								class UNiagaraSpriteRendererProperties* SpriteRenderer, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties);
+	void AddSpriteRendererData(SNiagaraUISystemWidget* NiagaraWidget, const FNiagaraEmitterInstance& EmitterInst,
+								const FNiagaraUIRendererEntry& Renderer, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties);
+
+	void AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraWidget, const FNiagaraEmitterInstance& EmitterInst,
+                                const FNiagaraUIRendererEntry& Renderer, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties);
 
-	void AddRibbonRendererData(SNiagaraUISystemWidget* NiagaraWidget, TSharedRef<const FNiagaraEmitterInstance> EmitterInst,
-                                class UNiagaraRibbonRendererProperties* RibbonRenderer, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties);
+	FNiagaraUISimulationState GetSimulationState();
 
+	// Returns true if any of the UI renderers has particles to draw
+	bool HasParticlesToRender();
 	
+	// Forces the cached renderer table to be rebuilt on the next paint. Call when the system asset changes
+	void InvalidateRendererCache();
+
+	// Sets what happens to the simulation once the widget wasn't visible for HiddenFrames frames
+	void SetHiddenPolicy(ENiagaraUIHiddenPolicy Policy, int32 HiddenFrames);
+
+	// Called by the widget on frames it's visible. Resumes a suspended simulation right away
+	void MarkWidgetVisible();
+
+	// Suspends the simulation if the widget wasn't visible for long enough. Called every frame by UNiagaraUISubsystem
+	void UpdateHiddenState();
+
+	bool IsSuspended() const { return Suspended; }
+
+	// Stops the simulation and clears the per-widget state before the component is kept in the pool
+	void OnReturnedToPool();
+
+	// Reconfigures a pooled component for a new widget. The simulation restarts on the first paint if AutoActivate is set
+	void OnReusedFromPool(bool AutoActivate, bool ShowDebugSystem, bool TickWhenPaused);
+
+	bool IsPooled() const { return Pooled; }
+
+	// Shared simulations keep the transform of the first widget that painted them, the other widgets only offset the particles
+	void SetSharedSimulation(bool Shared);
+
+	bool IsSharedSimulation() const { return SharedSimulation; }
+
+	/**
+	 *	Steps the simulation at Rate Hz instead of every frame. Particles are interpolated between the last two steps at the display rate,
+	 *	which requires the emitters to have persistent IDs. 0 simulates every frame
+	 */
+	void SetSimulationRate(float Rate);
+
+	float GetSimulationRate() const { return SimulationRate; }
+
+	// Reduced rate and tick when paused simulations run solo. Only called when those settings change, as switching recreates the system instance
+	void UpdateForceSolo();
+
+	// Widgets rendering this component. Used to invalidate all of them when the simulation is restarted or changed
+	void RegisterWidget(const TSharedRef<SNiagaraUISystemWidget>& Widget);
+	void UnregisterWidget(const SNiagaraUISystemWidget* Widget);
+	void InvalidateWidgets();
+
+	const TArray<TWeakPtr<SNiagaraUISystemWidget>>& GetWidgets() const { return Widgets; }
+
+	// Copies the bound particle streams of all renderers, together with the IDs, ribbon link data and previous positions the worker needs
+	TSharedRef<const FNiagaraUIParticleSnapshot, ESPMode::ThreadSafe> CaptureParticleSnapshot();
+
+	// Generates the render data from a snapshot. Doesn't touch the simulation, so it can run on any thread
+	static void RenderSnapshot(SNiagaraUISystemWidget* NiagaraWidget, const FNiagaraUIParticleSnapshot& Snapshot, const FNiagaraUIRenderProperties& RenderProperties, const FNiagaraWidgetProperties* WidgetProperties);
+
+	// Scalar parameter of the materials expanding instanced sprite records. Create Instanced Niagara UI Material adds it together with the expansion
+	static const FName InstancedSpritesParameter;
+
+	// True if the material expands the instanced sprite records. Sprites of other materials are drawn with vertices even with Use Instanced Sprites
+	static bool IsInstancedSpriteMaterial(const UMaterialInterface* Material);
+
+#if WITH_EDITOR
+	// Stores the current particles of all sprite renderers as the given frame of the baked effect
+	void RecordBakedFrame(UNiagaraUIBakedEffect* BakedEffect, int32 FrameIndex);
+#endif
+
+protected:
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+	
+private:
+	void Suspend();
+	void Resume();
+	
+	bool IsRendererCacheValid(const FNiagaraSystemInstance& SystemInstance) const;
+	
+	void UpdateRendererCache(const FNiagaraSystemInstance& SystemInstance);
+
+	// Copies the particle positions before the simulation steps over them
+	void CaptureParticleHistory(const FNiagaraSystemInstance& SystemInstance);
+
+	// Returns the renderer's positions interpolated between the previous and the current step, allocated on the mem stack. Null if there's nothing to interpolate
+	const float* InterpolatePositions(const FNiagaraUIRendererEntry& Renderer, const FNiagaraDataBuffer& ParticleData, const FNiagaraUIFloatAttribute& PositionAttribute, int32 ParticleCount) const;
 	
 private:
 	bool AutoActivateParticle = false;
@@ -56,7 +319,35 @@ private:
 	// Indicates if the position of the transform was ever set based on the UI position
 	bool HasSetTransform = false;
 
-	// Cached angle of the widget
-	float WidgetRotationAngle;
-	
+	// Enabled CPU sprite and ribbon renderers of the system, sorted by their sort order hint
+	TArray<FNiagaraUIRendererEntry> CachedRenderers;
+
+	// Emitter instances the renderer table was built for. The system instance recreates them when it's recompiled or reinitialized. Weak pointers
+	// don't match a new instance allocated at the address of a destroyed one
+	TArray<TWeakPtr<FNiagaraEmitterInstance, ESPMode::ThreadSafe>> CachedEmitterInstances;
+
+	// Instance IDs are never reused, unlike the instance addresses
+	uint64 CachedSystemInstanceID = 0;
+
+	bool RendererCacheDirty = true;
+
+	ENiagaraUIHiddenPolicy HiddenPolicy = ENiagaraUIHiddenPolicy::KeepSimulating;
+	int32 HiddenFramesToSuspend = 10;
+
+	uint64 LastVisibleFrame = 0;
+	bool Suspended = false;
+	bool Pooled = false;
+	bool SharedSimulation = false;
+
+	float SimulationRate = 0.f;
+	float InterpolationAlpha = 1.f;
+
+	// Tick count of the system when the particle history was captured
+	int32 HistoryTickCount = INDEX_NONE;
+
+	TArray<TWeakPtr<SNiagaraUISystemWidget>> Widgets;
+
+	// State before the suspension, restored when the simulation resumes
+	bool WasActiveBeforeSuspend = false;
+	bool WasPausedBeforeSuspend = false;
 };
@@ -0,0 +1,111 @@
+// Copyright 2024 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FNiagaraDataSet;
+class FNiagaraDataBuffer;
+class UNiagaraSpriteRendererProperties;
+class UNiagaraRibbonRendererProperties;
+
+// Location of a float particle attribute inside the data set layout. Resolved once per emitter, so the paint path doesn't need to look attributes up by name
+struct NIAGARAUIRENDERER_API FNiagaraUIFloatAttribute
+{
+public:
+	void Resolve(const FNiagaraDataSet& DataSet, FName AttributeName, int32 NumComponents);
+
+	bool IsBound() const { return ComponentStart != INDEX_NONE; }
+	
+public:
+	int32 ComponentStart = INDEX_NONE;
+};
+
+// Location of an int32 particle attribute inside the data set layout, such as the persistent particle ID
+struct NIAGARAUIRENDERER_API FNiagaraUIInt32Attribute
+{
+public:
+	void Resolve(const FNiagaraDataSet& DataSet, FName AttributeName, int32 NumComponents);
+
+	bool IsBound() const { return ComponentStart != INDEX_NONE; }
+	
+public:
+	int32 ComponentStart = INDEX_NONE;
+};
+
+// Raw view of a float attribute's per-component streams in a particle buffer. Unbound attributes read their default value for every particle
+struct NIAGARAUIRENDERER_API FNiagaraUIFloatStream
+{
+public:
+	FNiagaraUIFloatStream(const FNiagaraDataBuffer& Buffer, const FNiagaraUIFloatAttribute& Attribute, const float* DefaultValue);
+
+	// View of streams decoded outside of a particle buffer, e.g. from a baked effect. Null data reads the default value for every particle
+	FNiagaraUIFloatStream(const float* InData, int32 InComponentStride, const float* DefaultValue);
+
+	FORCEINLINE float Get(int32 Component, int32 Index) const
+	{
+		return Data[Component * ComponentStride + (Index & IndexMask)];
+	}
+
+	FORCEINLINE FVector2f GetVector2(int32 Index) const
+	{
+		return FVector2f(Get(0, Index), Get(1, Index));
+	}
+	
+	FORCEINLINE FVector4f GetVector4(int32 Index) const
+	{
+		return FVector4f(Get(0, Index), Get(1, Index), Get(2, Index), Get(3, Index));
+	}
+	
+	FORCEINLINE FLinearColor GetColor(int32 Index) const
+	{
+		return FLinearColor(Get(0, Index), Get(1, Index), Get(2, Index), Get(3, Index));
+	}
+
+	// First component of the stream, or the default value if the attribute is unbound
+	FORCEINLINE const float* GetComponentData(int32 Component) const
+	{
+		return Data + Component * ComponentStride;
+	}
+
+	bool IsBound() const { return IndexMask != 0; }
+	
+public:
+	static const float Zeros[4];
+	static const float Ones[4];
+	
+private:
+	const float* Data;
+	int32 ComponentStride;
+	int32 IndexMask;
+};
+
+// Attributes read by the sprite vertex builder
+struct NIAGARAUIRENDERER_API FNiagaraUISpriteLayout
+{
+public:
+	void Resolve(const FNiagaraDataSet& DataSet, const UNiagaraSpriteRendererProperties* SpriteRenderer);
+	
+public:
+	FNiagaraUIFloatAttribute Position;
+	FNiagaraUIFloatAttribute Color;
+	FNiagaraUIFloatAttribute Velocity;
+	FNiagaraUIFloatAttribute Alignment;
+	FNiagaraUIFloatAttribute Size;
+	FNiagaraUIFloatAttribute Rotation;
+	FNiagaraUIFloatAttribute SubImage;
+	FNiagaraUIFloatAttribute DynamicMaterial;
+};
+
+// Float attributes read by the ribbon vertex builder. Link order and ribbon IDs are read through the renderer's own accessors
+struct NIAGARAUIRENDERER_API FNiagaraUIRibbonLayout
+{
+public:
+	void Resolve(const FNiagaraDataSet& DataSet, const UNiagaraRibbonRendererProperties* RibbonRenderer);
+	
+public:
+	FNiagaraUIFloatAttribute Position;
+	FNiagaraUIFloatAttribute Color;
+	FNiagaraUIFloatAttribute Width;
+	FNiagaraUIFloatAttribute DynamicMaterial;
+};
@@ -5,6 +5,10 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+struct IConsoleVariable;
+
+NIAGARAUIRENDERER_API DECLARE_LOG_CATEGORY_EXTERN(LogNiagaraUIRenderer, Log, All);
+
 class FNiagaraUIRendererModule : public IModuleInterface
 {
 public:
@@ -12,4 +16,13 @@ public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+private:
+	void OnPostEngineInit();
+	
+	void OnEffectsQualityChanged(IConsoleVariable* Variable);
+
+private:
+	FDelegateHandle PostEngineInitHandle;
+	FDelegateHandle EffectsQualityChangedHandle;
 };
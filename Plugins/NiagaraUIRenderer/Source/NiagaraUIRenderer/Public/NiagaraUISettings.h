@@ -0,0 +1,134 @@
+// Copyright 2024 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "NiagaraUISettings.generated.h"
+
+// Scalability values of one sg.EffectsQuality level. Device profiles can still override the matching niagaraui.* console variables
+USTRUCT()
+struct NIAGARAUIRENDERER_API FNiagaraUIQualityLevelSettings
+{
+	GENERATED_BODY()
+
+public:
+	// niagaraui.Enable - Should the UI particles be drawn at all?
+	UPROPERTY(EditAnywhere, Category = "Quality")
+	bool Enable = true;
+
+	// niagaraui.MaxParticlesPerRenderer - Maximum number of sprites per sprite renderer and particles per ribbon. 0 means unlimited
+	UPROPERTY(EditAnywhere, Category = "Quality", meta = (ClampMin = 0))
+	int32 MaxParticlesPerRenderer = 0;
+
+	// niagaraui.RibbonDecimationTolerance - Ribbon particles closer than this many pixels to the line between their neighbours are skipped
+	UPROPERTY(EditAnywhere, Category = "Quality", meta = (ClampMin = 0.f))
+	float RibbonDecimationTolerance = 0.f;
+
+	// niagaraui.UpdateRateDivisor - Vertices of widgets that didn't move are regenerated only every N-th frame
+	UPROPERTY(EditAnywhere, Category = "Quality", meta = (ClampMin = 1))
+	int32 UpdateRateDivisor = 1;
+
+	// niagaraui.MinParticleScreenSize - Minimum particle screen size in pixels used by all widgets
+	UPROPERTY(EditAnywhere, Category = "Quality", meta = (ClampMin = 0.f))
+	float MinParticleScreenSize = 0.f;
+
+	// niagaraui.VertexBudget - Maximum number of vertices of all widgets in a frame. 0 means unlimited
+	UPROPERTY(EditAnywhere, Category = "Quality", meta = (ClampMin = 0))
+	int32 VertexBudget = 0;
+
+	// niagaraui.DrawBudget - Maximum number of draw elements of all widgets in a frame. 0 means unlimited
+	UPROPERTY(EditAnywhere, Category = "Quality", meta = (ClampMin = 0))
+	int32 DrawBudget = 0;
+};
+
+/**
+ * Project defaults of the niagaraui.* console variables. Quality levels are applied whenever sg.EffectsQuality changes
+ */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Niagara UI Renderer"))
+class NIAGARAUIRENDERER_API UNiagaraUISettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UNiagaraUISettings();
+	
+	virtual FName GetCategoryName() const override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	// Pushes the project defaults and the quality level matching the current sg.EffectsQuality to the console variables
+	void ApplySettings() const;
+
+	const FNiagaraUIQualityLevelSettings& GetQualityLevelSettings(int32 QualityLevel) const;
+
+public:
+	UPROPERTY(config, EditAnywhere, Category = "Scalability")
+	FNiagaraUIQualityLevelSettings Low;
+	
+	UPROPERTY(config, EditAnywhere, Category = "Scalability")
+	FNiagaraUIQualityLevelSettings Medium;
+	
+	UPROPERTY(config, EditAnywhere, Category = "Scalability")
+	FNiagaraUIQualityLevelSettings High;
+	
+	UPROPERTY(config, EditAnywhere, Category = "Scalability")
+	FNiagaraUIQualityLevelSettings Epic;
+	
+	UPROPERTY(config, EditAnywhere, Category = "Scalability")
+	FNiagaraUIQualityLevelSettings Cinematic;
+
+	// niagaraui.CullParticles - Skip sprites and ribbon segments outside of the widget's culling rect
+	UPROPERTY(config, EditAnywhere, Category = "Culling")
+	bool CullParticles = true;
+
+	// niagaraui.SuspendHiddenWidgets - Apply the Hidden Policy of the widgets
+	UPROPERTY(config, EditAnywhere, Category = "Culling")
+	bool SuspendHiddenWidgets = true;
+
+	// niagaraui.SpriteKernel - Generate sprite vertices four particles at a time with vector intrinsics
+	UPROPERTY(config, EditAnywhere, Category = "Vertex Generation")
+	bool UseSIMDSpriteKernel = true;
+
+	// niagaraui.ParallelSpriteThreshold - Sprite renderers with at least this many particles generate their vertices on multiple threads. 0 disables it
+	UPROPERTY(config, EditAnywhere, Category = "Vertex Generation", meta = (ClampMin = 0))
+	int32 ParallelSpriteThreshold = 4096;
+
+	// niagaraui.ParallelSpriteChunkSize - Number of particles processed by one task of the parallel sprite vertex generation
+	UPROPERTY(config, EditAnywhere, Category = "Vertex Generation", meta = (ClampMin = 4))
+	int32 ParallelSpriteChunkSize = 1024;
+
+	// niagaraui.AsyncVertexGeneration - Generate the vertices of all widgets from particle snapshots on worker threads instead of when the widgets are painted
+	UPROPERTY(config, EditAnywhere, Category = "Vertex Generation")
+	bool AsyncVertexGeneration = false;
+
+	// niagaraui.ParticleSnapshots - 0 disables particle snapshots, 1 uses them for widgets with Use Particle Snapshot enabled, 2 for all widgets
+	UPROPERTY(config, EditAnywhere, Category = "Vertex Generation", meta = (ClampMin = 0, ClampMax = 2))
+	int32 ParticleSnapshots = 1;
+
+	// niagaraui.InstancedSprites - Let widgets with Use Instanced Sprites upload one packed record per sprite instead of four vertices
+	UPROPERTY(config, EditAnywhere, Category = "Vertex Generation")
+	bool InstancedSprites = true;
+
+	// niagaraui.MergeRenderSlots - Merge consecutive renderers drawn with the same material into a single draw element
+	UPROPERTY(config, EditAnywhere, Category = "Vertex Generation")
+	bool MergeRenderSlots = true;
+
+	// niagaraui.BudgetMinFraction - Widgets that would get less than this fraction of their particles from the vertex budget are skipped instead
+	UPROPERTY(config, EditAnywhere, Category = "Budget", meta = (ClampMin = 0.f, ClampMax = 1.f))
+	float BudgetMinFraction = 0.1f;
+
+	// niagaraui.BudgetLogInterval - Minimum number of seconds between warnings about the budget being exceeded
+	UPROPERTY(config, EditAnywhere, Category = "Budget", meta = (ClampMin = 0.f))
+	float BudgetLogInterval = 5.f;
+
+	// niagaraui.ComponentPoolSize - Maximum number of released components kept per Niagara system for reuse. 0 disables pooling
+	UPROPERTY(config, EditAnywhere, Category = "Pooling", meta = (ClampMin = 0))
+	int32 ComponentPoolSize = 8;
+
+	// niagaraui.ComponentPoolCleanupTime - Pooled components unused for this many seconds are destroyed
+	UPROPERTY(config, EditAnywhere, Category = "Pooling", meta = (ClampMin = 0.f))
+	float ComponentPoolCleanupTime = 30.f;
+};
@@ -0,0 +1,119 @@
+// Copyright 2024 - Michal Smoleň
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "NiagaraUISubsystem.generated.h"
+
+class UNiagaraSystem;
+class UNiagaraUIComponent;
+class ANiagaraUIActor;
+class SNiagaraUISystemWidget;
+
+USTRUCT()
+struct FNiagaraUIPooledComponent
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+	TObjectPtr<UNiagaraUIComponent> Component;
+
+	// Real time the component was returned to the pool
+	double LastUsedTime = 0.0;
+
+	SIZE_T MemorySize = 0;
+};
+
+// Component simulating a system for all widgets with the same shared simulation key
+struct FNiagaraUISharedSimulation
+{
+	TWeakObjectPtr<UNiagaraUIComponent> Component;
+	int32 NumUsers = 0;
+};
+
+// Released components of one Niagara system
+USTRUCT()
+struct FNiagaraUIComponentPool
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+	TArray<FNiagaraUIPooledComponent> FreeComponents;
+};
+
+/**
+ * Owns the single actor hosting all UI particle components of a world, pools the released components per Niagara system,
+ * keeps track of the components, generates their widgets' vertices asynchronously from particle snapshots, and suspends the simulation of those whose widgets aren't visible
+ */
+UCLASS()
+class NIAGARAUIRENDERER_API UNiagaraUISubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickableWhenPaused() const override { return true; }
+
+	void RegisterComponent(UNiagaraUIComponent* Component);
+	void UnregisterComponent(UNiagaraUIComponent* Component);
+
+	// Reuses a pooled component of the system or creates a new one on the shared host actor. Returns nullptr if the world can't spawn actors
+	UNiagaraUIComponent* AcquireComponent(UNiagaraSystem* NiagaraSystemTemplate, bool AutoActivate, bool ShowDebugSystem, bool TickWhenPaused);
+
+	// Returns the component simulating the system for all widgets with the same key, creating it on first use. Empty key acquires an unshared component.
+	// OutCreated is set if the component was acquired for this call, the widgets reusing a shared one don't configure it
+	UNiagaraUIComponent* AcquireSharedComponent(UNiagaraSystem* NiagaraSystemTemplate, FName SharedSimulationKey, bool AutoActivate, bool ShowDebugSystem, bool TickWhenPaused, bool* OutCreated = nullptr);
+
+	// Returns a component previously returned by AcquireComponent to the pool, or destroys it when the pool of its system is full.
+	// Shared components are released once the last widget using them releases them
+	void ReleaseComponent(UNiagaraUIComponent* Component);
+
+	// Destroys all pooled components
+	void ClearPool();
+
+	// Returns the host actor, spawning it on first use
+	ANiagaraUIActor* GetHostActor();
+
+	// Waits for the asynchronous vertex generation of all widgets. Call before changing a widget's render data outside of its paint
+	void WaitForAsyncRenderData();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void CleanupPool();
+
+	// Captures the particle snapshots and launches one task per component. Runs before Slate ticks, so the world, Niagara's own
+	// post actor tick work and any deferred spawns are done. UMG ticks before the paint can't race the tasks, as they only read the copies
+	void OnSlatePreTick(float DeltaTime);
+
+private:
+	UPROPERTY(Transient)
+	TObjectPtr<ANiagaraUIActor> HostActor;
+
+	UPROPERTY(Transient)
+	TMap<TObjectPtr<UNiagaraSystem>, FNiagaraUIComponentPool> ComponentPools;
+
+	TMap<TPair<TObjectKey<UNiagaraSystem>, FName>, FNiagaraUISharedSimulation> SharedSimulations;
+	
+	SIZE_T PooledMemory = 0;
+	int32 NumPooledComponents = 0;
+
+	FGraphEventArray SnapshotRenderTasks;
+
+	// Widgets with a task in flight are kept alive until it finishes, so they are never destroyed on a worker thread
+	TArray<TSharedRef<SNiagaraUISystemWidget>> SnapshotRenderWidgets;
+
+	FDelegateHandle SlatePreTickHandle;
+	
+	TArray<TWeakObjectPtr<UNiagaraUIComponent>> Components;
+};
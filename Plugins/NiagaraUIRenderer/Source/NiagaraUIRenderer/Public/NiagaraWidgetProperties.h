@@ -18,4 +18,20 @@ struct FNiagaraWidgetProperties
 	bool PassDynamicParametersFromRibbon = false;
 	bool FakeDepthScale = false;
 	float FakeDepthScaleDistance = 1000.f;
+
+	// Number of frames the render buffers can stay over-allocated before they are shrunk. 0 keeps them at their high-water mark
+	int32 RenderBufferShrinkDelay = 0;
+
+	// Particles smaller than this many pixels are dropped or thinned out. 0 disables it
+	float MinParticleScreenSize = 0.f;
+	bool ThinSubPixelParticles = true;
+
+	// Widgets with higher priority get their share of the global vertex and draw budget first
+	int32 BudgetPriority = 0;
+
+	// Vertices are built on a worker from a copy of the particles taken before Slate ticks, when enabled by niagaraui.ParticleSnapshots
+	bool UseParticleSnapshot = false;
+
+	// Sprites are uploaded as packed per instance records and expanded by the material, when enabled by niagaraui.InstancedSprites
+	bool UseInstancedSprites = false;
 };
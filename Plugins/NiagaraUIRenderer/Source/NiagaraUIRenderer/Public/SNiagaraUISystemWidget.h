@@ -3,10 +3,13 @@
 #pragma once
 
 #include "NiagaraWidgetProperties.h"
+#include "NiagaraUIComponent.h"
 #include "SlateMaterialBrush.h"
 #include "Slate/SMeshWidget.h"
+#include "Async/TaskGraphInterfaces.h"
 
 class UNiagaraUIComponent;
+class UNiagaraUIBakedEffect;
 class UMaterialInterface;
 
 /**
@@ -34,17 +37,59 @@ public:
 	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
 	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
 
-	void AddRenderData(FSlateVertex** OutVertexData, SlateIndex** OutIndexData, UMaterialInterface* Material, int32 NumVertexData, int32 NumIndexData);
+	// Adds a render data slot to the frame being generated. Can be called from the asynchronous generation, the slot's brush is resolved on the game thread once the frame is published.
+	// Thinned slots are sprites reduced to the fraction granted by the budget
+	void AddRenderData(FSlateVertex** OutVertexData, SlateIndex** OutIndexData, UMaterialInterface* Material, int32 NumVertexData, int32 NumIndexData, bool Thinned = false);
+
+	// Adds a render data slot drawing one quad per instance record. The quad's vertices sit at Origin and carry the sub image grid for the material
+	void AddInstancedRenderData(FVector4f** OutInstanceData, UMaterialInterface* Material, int32 NumInstances, FVector2f Origin, FVector2f SubImageSize);
+
+	// Shrinks the render data added last to the given size, e.g. after culling. The slot is dropped if nothing is left to draw
+	void TrimRenderData(int32 NumVertexData, int32 NumIndexData);
+
+	// Shrinks the instanced render data added last to the given number of instances. The slot is dropped if nothing is left to draw
+	void TrimInstanceData(int32 NumInstances);
 	
+	// Marks all render data slots as unused. The slots keep their memory, so they can be reused by the next frame
 	void ClearRenderData();
 
+	// Called after all render data for this frame were added. Shrinks or releases slots that stayed over-allocated for too long
+	void FinishRenderData();
+
+	// Releases all render data slots including their memory
+	void ReleaseRenderData();
+
+	// Forces the render data to be regenerated on the next paint, even if the simulation and the widget geometry didn't change
+	void InvalidateRenderData();
+
+	// Lets Slate cache this widget. The widget then invalidates its paint only on frames when the particle data changed
+	void SetNonVolatile(bool NonVolatile);
+
 	TSharedPtr<FSlateMaterialBrush> CreateSlateMaterialBrush(UMaterialInterface* Material);
 
 	void CheckForInvalidBrushes();
 
 	void SetNiagaraComponentReference(TWeakObjectPtr<UNiagaraUIComponent> NiagaraComponentIn);
+
+	// Plays the baked effect instead of simulating the component. Null returns to the component
+	void SetBakedEffect(UNiagaraUIBakedEffect* Effect, bool AutoPlay);
+
+	// Restarts the baked effect from its first frame
+	void PlayBakedEffect();
+	void StopBakedEffect();
 	void SetNiagaraWidgetProperties(FNiagaraWidgetProperties Properties);
 
+	// Called on the game thread before Slate ticks. Returns true if the simulation changed since the last paint and the next frame should be generated asynchronously
+	bool PrepareAsyncRenderData();
+
+	// Generates the next frame into the back buffer from a particle snapshot of the component. Runs on a worker thread and doesn't touch the simulation
+	void BuildSnapshotRenderData(const FNiagaraUIParticleSnapshot& Snapshot);
+
+	// True if the widget's frames are built asynchronously, from particle snapshots of the component
+	bool UsesParticleSnapshot() const;
+
+	void SetAsyncRenderTask(const FGraphEventRef& Task) { AsyncRenderTask = Task; }
+
 	void SetDesiredSize(FVector2D NewDesiredSize);
 	void SetColorAndOpacity(FLinearColor NewColorAndOpacity);
 
@@ -54,8 +99,117 @@ public:
 	//~ End FGCObject Interface
 
 private:
+	UMaterialInterface* GetRemappedMaterial(UMaterialInterface* Material) const;
+
+	void RegisterParticleDataTimer();
+
+	EActiveTimerReturnType CheckParticleDataChanged(double InCurrentTime, float InDeltaTime);
+
+	// Waits for the asynchronous generation and makes its frame the painted one. Returns false if no frame was generated
+	bool PublishAsyncRenderData();
+
+	// Creates the brushes of the frame's slots and uploads their instance data. Slate resource handles can only be created on the game thread
+	void ResolveRenderDataBrushes();
+
+	// Appends the vertices of consecutive slots drawn with the same brush to the first of them, so they are drawn with a single element
+	void MergeRenderSlots();
+
+	void UpdateRenderDemand(float ParticleFraction);
+
+private:
+	struct FNiagaraUIRenderSlot
+	{
+		TArray<FSlateVertex> VertexData;
+		TArray<SlateIndex> IndexData;
+		TSharedPtr<FSlateMaterialBrush> Brush;
+		FSlateResourceHandle RenderingResourceHandle;
+
+		// Material added by the renderer, before the remapping
+		UMaterialInterface* Material = nullptr;
+
+		// Remapped material the brush was created for
+		UMaterialInterface* BrushMaterial = nullptr;
+
+		// Instanced slots draw their single quad once per record. The records are a persistent staging array, a copy of them is uploaded to the buffer
+		bool Instanced = false;
+		FSlateInstanceBufferData InstanceData;
+		TSharedPtr<ISlateUpdatableInstanceBuffer> InstanceBuffer;
+		int32 NumInstances = 0;
+
+		// Merged slots were appended to an earlier slot with the same brush and aren't drawn on their own
+		bool Merged = false;
+
+		// Sprites drawn with the budget's particle fraction. Ribbons aren't thinned, so their vertices don't grow the demand
+		bool Thinned = false;
+
+		// Number of consecutive frames this slot was unused or used only a fraction of its memory
+		int32 UnderusedFrames = 0;
+	};
+
+	// Everything the render data depends on. When these don't change between paints, last frame's render data is reused
+	struct FNiagaraUIRenderInputs
+	{
+	public:
+		bool operator==(const FNiagaraUIRenderInputs& Other) const
+		{
+			return SimulationState == Other.SimulationState && BakedFrameIndex == Other.BakedFrameIndex && RenderProperties == Other.RenderProperties && Location == Other.Location && Scale == Other.Scale && Angle == Other.Angle;
+		}
+		
+	public:
+		FNiagaraUISimulationState SimulationState;
+		int32 BakedFrameIndex = INDEX_NONE;
+		FNiagaraUIRenderProperties RenderProperties = FNiagaraUIRenderProperties(0.f, FVector2f::ZeroVector, FLinearColor::Transparent);
+		FVector2D Location = FVector2D::ZeroVector;
+		FVector2f Scale = FVector2f::ZeroVector;
+		float Angle = 0.f;
+	};
+
+	FNiagaraUIRenderInputs LastRenderInputs;
+
+	bool RenderDataDirty = true;
+
+	// Whether the last paint was at least partially inside the window. Keeps the simulation of cached widgets awake between their paints
+	bool LastPaintVisible = false;
+
+	// Vertex and draw counts of the last generated render data if all particles were drawn. Requested from the budget subsystem every paint
+	int32 VertexDemand = 0;
+	int32 DrawDemand = 0;
+
+	// Fraction of particles the budget granted at the last paint. Below one, cached widgets keep polling for a new grant
+	float LastGrantedFraction = 1.f;
+
+	// Polls the simulation while the widget is non-volatile. Stopped while the system is inactive and not throttled by the budget
+	TWeakPtr<FActiveTimerHandle> ParticleDataTimerHandle;
+	
+	// Render data of one generated frame
+	struct FNiagaraUIRenderData
+	{
+	public:
+		// Render data slots persist between frames and are reused in the same order the renderers add them
+		TArray<FNiagaraUIRenderSlot> RenderSlots;
+
+		int32 NumActiveRenderSlots = 0;
+	};
+
+	// The painted frame and the one generated asynchronously for the next paint. Synchronous generation builds the painted frame in place
+	FNiagaraUIRenderData RenderData[2];
+	int32 PaintedRenderData = 0;
+	int32 BuiltRenderData = 0;
+
+	// Inputs of the last paint, reused by the asynchronous generation
+	FNiagaraUIRenderInputs AsyncRenderInputs;
+	bool AsyncRenderDataRequested = false;
+	bool AsyncRenderDataPending = false;
+	FGraphEventRef AsyncRenderTask;
+
 	TWeakObjectPtr<UNiagaraUIComponent> NiagaraComponent;
 
+	TWeakObjectPtr<UNiagaraUIBakedEffect> BakedEffect;
+
+	// Application time of the first paint after the playback started. Negative until then
+	double BakedPlaybackStartTime = -1.0;
+	bool BakedPlaybackActive = false;
+
 	static TMap<TObjectPtr<UMaterialInterface>, TSharedPtr<FSlateMaterialBrush>> MaterialBrushMap;
 
 	FNiagaraWidgetProperties WidgetProperties = FNiagaraWidgetProperties(nullptr, true, false, false, false, 1.f);
@@ -10,8 +10,18 @@
 #include "MaterialGraph/MaterialGraph.h"
 #include "Materials/MaterialExpressionVertexColor.h"
 #include "Materials/MaterialExpressionParticleColor.h"
+#include "Materials/MaterialExpressionAppendVector.h"
+#include "Materials/MaterialExpressionCustom.h"
+#include "Materials/MaterialExpressionScalarParameter.h"
+#include "Materials/MaterialExpressionTextureCoordinate.h"
 #include "IContentBrowserSingleton.h"
 #include "Framework/MultiBox/MultiBoxBuilder.h"
+#include "NiagaraSystem.h"
+#include "NiagaraUIBakedEffect.h"
+#include "NiagaraUIComponent.h"
+#include "NiagaraUISubsystem.h"
+#include "Editor.h"
+#include "Misc/ScopedSlowTask.h"
 
 #if ENGINE_MINOR_VERSION >= 2
 #include "MaterialDomain.h"
@@ -39,12 +49,126 @@ public:
 
 struct FCreateNiagaraUIMaterialsExtension : public FContentBrowserSelectedAssetExtensionBase
 {
+public:
+	// Also expands the packed sprite records of Use Instanced Sprites
+	bool Instanced = false;
+
+public:
+	static UMaterialExpressionCustom* CreateInstancedSpriteExpression(UMaterial* Material, const TCHAR* Description, const TCHAR* Code, ECustomMaterialOutputType OutputType, int32 EditorY)
+	{
+		UMaterialExpressionCustom* Custom = Cast<UMaterialExpressionCustom>(UMaterialEditingLibrary::CreateMaterialExpression(Material, UMaterialExpressionCustom::StaticClass(), -600, EditorY));
+		
+		Custom->Description = Description;
+		Custom->Code = Code;
+		Custom->OutputType = OutputType;
+		Custom->IncludeFilePaths.Add(TEXT("/Plugin/NiagaraUIRenderer/Private/NiagaraUIInstancedSprite.ush"));
+		Custom->Inputs.Reset();
+
+		return Custom;
+	}
+
+	static void AddInstancedSpriteInput(UMaterialExpressionCustom* Custom, const TCHAR* Name, UMaterialExpression* Expression)
+	{
+		FCustomInput& Input = Custom->Inputs.AddDefaulted_GetRef();
+		Input.InputName = Name;
+		Input.Input.Connect(0, Expression);
+	}
+
+	// Wires up the functions of Shaders/Private/NiagaraUIInstancedSprite.ush. The vertex shader moves the corners to the sprite and passes its
+	// UV and color on in customized UVs, so the vertex colors of the material read those instead
+	static void AddInstancedSpriteExpansion(UMaterial* Material)
+	{
+		auto CreateTextureCoordinate = [Material](int32 CoordinateIndex, int32 EditorX, int32 EditorY)
+		{
+			UMaterialExpressionTextureCoordinate* TextureCoordinate = Cast<UMaterialExpressionTextureCoordinate>(
+				UMaterialEditingLibrary::CreateMaterialExpression(Material, UMaterialExpressionTextureCoordinate::StaticClass(), EditorX, EditorY));
+			
+			TextureCoordinate->CoordinateIndex = CoordinateIndex;
+			return TextureCoordinate;
+		};
+
+		// Vertex texture coordinates inside the customized UVs, the corner and the sub image grid of the quad
+		UMaterialExpressionTextureCoordinate* Corner = CreateTextureCoordinate(0, -900, -600);
+		UMaterialExpressionTextureCoordinate* SubImageSize = CreateTextureCoordinate(1, -900, -450);
+
+		UMaterialExpressionScalarParameter* Enabled = Cast<UMaterialExpressionScalarParameter>(
+			UMaterialEditingLibrary::CreateMaterialExpression(Material, UMaterialExpressionScalarParameter::StaticClass(), -900, -750));
+		
+		Enabled->ParameterName = UNiagaraUIComponent::InstancedSpritesParameter;
+		Enabled->DefaultValue = 1.f;
+
+		UMaterialExpressionCustom* Offset = CreateInstancedSpriteExpression(Material, TEXT("Instanced Sprite Offset"),
+			TEXT("return NiagaraUIInstancedSpriteVertexOffset(Parameters, Corner) * Enabled;"), CMOT_Float3, -750);
+		AddInstancedSpriteInput(Offset, TEXT("Corner"), Corner);
+		AddInstancedSpriteInput(Offset, TEXT("Enabled"), Enabled);
+
+		UMaterialExpressionCustom* UV = CreateInstancedSpriteExpression(Material, TEXT("Instanced Sprite UV"),
+			TEXT("return NiagaraUIInstancedSpriteVertexUV(Parameters, Corner, SubImageSize);"), CMOT_Float2, -600);
+		AddInstancedSpriteInput(UV, TEXT("Corner"), Corner);
+		AddInstancedSpriteInput(UV, TEXT("SubImageSize"), SubImageSize);
+
+		UMaterialExpressionCustom* ColorRG = CreateInstancedSpriteExpression(Material, TEXT("Instanced Sprite Color RG"),
+			TEXT("return NiagaraUIInstancedSpriteVertexColor(Parameters).rg;"), CMOT_Float2, -450);
+		
+		UMaterialExpressionCustom* ColorBA = CreateInstancedSpriteExpression(Material, TEXT("Instanced Sprite Color BA"),
+			TEXT("return NiagaraUIInstancedSpriteVertexColor(Parameters).ba;"), CMOT_Float2, -300);
+
+		UMaterialEditingLibrary::ConnectMaterialProperty(Offset, FString(), MP_WorldPositionOffset);
+		UMaterialEditingLibrary::ConnectMaterialProperty(UV, FString(), MP_CustomizedUVs0);
+		UMaterialEditingLibrary::ConnectMaterialProperty(ColorRG, FString(), MP_CustomizedUVs1);
+		UMaterialEditingLibrary::ConnectMaterialProperty(ColorBA, FString(), MP_CustomizedUVs2);
+		Material->NumCustomizedUVs = FMath::Max(Material->NumCustomizedUVs, 3);
+
+		// Outside of the customized UVs the texture coordinates read their interpolated values
+		UMaterialExpressionAppendVector* Color = Cast<UMaterialExpressionAppendVector>(
+			UMaterialEditingLibrary::CreateMaterialExpression(Material, UMaterialExpressionAppendVector::StaticClass(), -600, -150));
+		
+		Color->A.Connect(0, CreateTextureCoordinate(1, -750, -150));
+		Color->B.Connect(0, CreateTextureCoordinate(2, -750, -50));
+
+#if ENGINE_MINOR_VERSION < 1
+		for (UMaterialExpression* Expression : Material->Expressions)
+#else
+		for (UMaterialExpression* Expression : Material->GetExpressions())
+#endif
+		{
+#if ENGINE_MINOR_VERSION <= 2
+			TArray<FExpressionInput*> Inputs = Expression->GetInputs();
+			for (FExpressionInput* Input : Inputs)
+#elif ENGINE_MINOR_VERSION < 5
+			TArrayView<FExpressionInput*> Inputs = Expression->GetInputsView();
+			for (FExpressionInput* Input : Inputs)
+#else
+			for (FExpressionInputIterator Input(Expression); Input; ++Input)
+#endif
+			{
+				// The channel masks of the vertex color outputs still apply to the appended color
+				if (Input->Expression && Input->Expression->IsA<UMaterialExpressionVertexColor>())
+				{
+					Input->Expression = Color;
+					Input->OutputIndex = 0;
+				}
+			}
+		}
+
+		for (int32 InputIndex = 0; InputIndex < MP_MAX; InputIndex++)
+		{
+			FExpressionInput* Input = Material->GetExpressionInputForProperty((EMaterialProperty)InputIndex);
+			
+			if (Input && Input->Expression && Input->Expression->IsA<UMaterialExpressionVertexColor>())
+			{
+				Input->Expression = Color;
+				Input->OutputIndex = 0;
+			}
+		}
+	}
+
 	void CreateNiagaraUIMaterials(TArray<UMaterial*>& Materials)
 	{
 		FAssetToolsModule& AssetToolsModule = FModuleManager::Get().LoadModuleChecked<FAssetToolsModule>("AssetTools");
 		FContentBrowserModule& ContentBrowserModule = FModuleManager::Get().LoadModuleChecked<FContentBrowserModule>("ContentBrowser");
 		
-		const FString DefaultSuffix = TEXT("_UI");
+		const FString DefaultSuffix = Instanced ? TEXT("_UIInstanced") : TEXT("_UI");
 
 		TArray<UObject*> NewMaterials;
 		
@@ -124,7 +248,9 @@ struct FCreateNiagaraUIMaterialsExtension : public FContentBrowserSelectedAssetE
 					UMaterialEditingLibrary::DeleteMaterialExpression(NewMaterial, Expression);
 				}
 			}
-			
+
+			if (Instanced)
+				AddInstancedSpriteExpansion(NewMaterial);
 
 			NewMaterial->PreEditChange(nullptr);
 			NewMaterial->PostEditChange();
@@ -159,6 +285,92 @@ struct FCreateNiagaraUIMaterialsExtension : public FContentBrowserSelectedAssetE
 	}
 };
 
+struct FBakeNiagaraUIEffectsExtension : public FContentBrowserSelectedAssetExtensionBase
+{
+	static void BakeEffect(UNiagaraUIBakedEffect* BakedEffect)
+	{
+		UNiagaraSystem* System = BakedEffect->SourceSystem.LoadSynchronous();
+		UWorld* World = GEditor ? GEditor->GetEditorWorldContext().World() : nullptr;
+		UNiagaraUISubsystem* Subsystem = World ? World->GetSubsystem<UNiagaraUISubsystem>() : nullptr;
+
+		if (!System || !Subsystem)
+			return;
+
+		UNiagaraUIComponent* Component = Subsystem->AcquireComponent(System, false, false, false);
+
+		if (!Component)
+			return;
+
+		const float DeltaTime = 1.f / FMath::Max(BakedEffect->FrameRate, 1.f);
+		const int32 NumWarmupFrames = FMath::FloorToInt(BakedEffect->WarmupTime / DeltaTime);
+		const int32 NumFrames = FMath::Max(FMath::CeilToInt(BakedEffect->Duration / DeltaTime), 1);
+
+		FScopedSlowTask SlowTask(NumFrames, FText::Format(LOCTEXT("NiagaraUIRenderer_BakingEffect", "Baking {0}"), FText::FromString(BakedEffect->GetName())));
+		SlowTask.MakeDialog();
+
+		// The simulation is stepped manually with the bake frame rate, independent of the editor world
+		Component->SetForceSolo(true);
+		Component->Activate(true);
+
+		if (NumWarmupFrames > 0)
+			Component->AdvanceSimulation(NumWarmupFrames, DeltaTime);
+
+		BakedEffect->Modify();
+		BakedEffect->BeginBake();
+
+		for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+		{
+			SlowTask.EnterProgressFrame();
+			
+			Component->AdvanceSimulation(1, DeltaTime);
+			Component->RecordBakedFrame(BakedEffect, FrameIndex);
+		}
+
+		BakedEffect->EndBake(NumFrames);
+		BakedEffect->PostEditChange();
+		BakedEffect->MarkPackageDirty();
+
+		Subsystem->ReleaseComponent(Component);
+	}
+	
+	virtual void Execute() override
+	{
+		FAssetToolsModule& AssetToolsModule = FModuleManager::Get().LoadModuleChecked<FAssetToolsModule>("AssetTools");
+		FContentBrowserModule& ContentBrowserModule = FModuleManager::Get().LoadModuleChecked<FContentBrowserModule>("ContentBrowser");
+
+		const FString DefaultSuffix = TEXT("_UIBaked");
+
+		TArray<UObject*> BakedEffects;
+		
+		for (const FAssetData& AssetData : SelectedAssets)
+		{
+			UObject* Asset = AssetData.GetAsset();
+			UNiagaraUIBakedEffect* BakedEffect = Cast<UNiagaraUIBakedEffect>(Asset);
+			
+			if (UNiagaraSystem* System = Cast<UNiagaraSystem>(Asset))
+			{
+				FString Name;
+				FString PackageName;
+				AssetToolsModule.Get().CreateUniqueAssetName(System->GetOutermost()->GetName(), DefaultSuffix, PackageName, Name);
+
+				BakedEffect = Cast<UNiagaraUIBakedEffect>(AssetToolsModule.Get().CreateAsset(Name, FPackageName::GetLongPackagePath(PackageName), UNiagaraUIBakedEffect::StaticClass(), nullptr));
+
+				if (BakedEffect)
+					BakedEffect->SourceSystem = System;
+			}
+
+			if (!BakedEffect)
+				continue;
+
+			BakeEffect(BakedEffect);
+			BakedEffects.Add(BakedEffect);
+		}
+
+		if (BakedEffects.Num() > 0)
+			ContentBrowserModule.Get().SyncBrowserToAssets(BakedEffects);
+	}
+};
+
 class FNiagaraUIContentBrowserExtension_Impl
 {
 public:
@@ -167,8 +379,29 @@ public:
 		SelectedAssetFunctor->Execute();
 	}
 
-	static void CreateNiagaraUIFunctions(FMenuBuilder& MenuBuilder, TArray<FAssetData> SelectedAssets)
+	static void CreateNiagaraUIFunctions(FMenuBuilder& MenuBuilder, TArray<FAssetData> SelectedAssets, bool AnyMaterials, bool AnyBakeableAssets)
 	{
+		if (AnyBakeableAssets)
+		{
+			TSharedPtr<FBakeNiagaraUIEffectsExtension> BakeEffectsFunctor = MakeShareable(new FBakeNiagaraUIEffectsExtension());
+			BakeEffectsFunctor->SelectedAssets = SelectedAssets;
+
+			FUIAction ActionBakeEffects(FExecuteAction::CreateStatic(&FNiagaraUIContentBrowserExtension_Impl::ExecuteSelectedContentFunctor, StaticCastSharedPtr<FContentBrowserSelectedAssetExtensionBase>(BakeEffectsFunctor)));
+
+			MenuBuilder.AddMenuEntry(
+				LOCTEXT("NiagaraUIRenderer_BakeUIEffect", "Bake Niagara UI Effect"),
+				LOCTEXT("NiagaraUIRenderer_BakeUIEffectTooltip", "Records the sprite particles of the selected Niagara Systems into baked effects, which the Niagara System Widget plays back without a simulation. Selected baked effects are baked again from their source system."),
+				FSlateIcon(FNiagaraUIRendererEditorStyle::GetStyleSetName(), "NiagaraUIRendererEditorStyle.ParticleIcon"),
+				ActionBakeEffects,
+				NAME_None,
+				EUserInterfaceActionType::Button
+			);
+		}
+
+		if (!AnyMaterials)
+			return;
+		
+
 		TArray<UMaterial*> Materials;
 		for (auto AssetIt = SelectedAssets.CreateConstIterator(); AssetIt; ++AssetIt)
 		{
@@ -192,6 +425,21 @@ public:
 			NAME_None,
 			EUserInterfaceActionType::Button
 		);
+
+		TSharedPtr<FCreateNiagaraUIMaterialsExtension> InstancedMaterialsFunctor = MakeShareable(new FCreateNiagaraUIMaterialsExtension());
+		InstancedMaterialsFunctor->SelectedAssets = SelectedAssets;
+		InstancedMaterialsFunctor->Instanced = true;
+
+		FUIAction ActionCreateInstancedMaterial(FExecuteAction::CreateStatic(&FNiagaraUIContentBrowserExtension_Impl::ExecuteSelectedContentFunctor, StaticCastSharedPtr<FContentBrowserSelectedAssetExtensionBase>(InstancedMaterialsFunctor)));
+		
+		MenuBuilder.AddMenuEntry(
+			LOCTEXT("NiagaraUIRenderer_CreateInstancedUIMaterial", "Create Instanced Niagara UI Material"),
+			LOCTEXT("NiagaraUIRenderer_CreateInstancedUIMaterialTooltip", "Creates a Niagara UI material that also expands the sprite records of widgets with Use Instanced Sprites. It uses World Position Offset and the first three customized UVs, so it can't read dynamic material parameters."),
+			FSlateIcon(FNiagaraUIRendererEditorStyle::GetStyleSetName(), "NiagaraUIRendererEditorStyle.ParticleIcon"),
+			ActionCreateInstancedMaterial,
+			NAME_None,
+			EUserInterfaceActionType::Button
+		);
 	}
 
 	static TSharedRef<FExtender> OnExtendContentBrowserAssetSelectionMenu(const TArray<FAssetData>& SelectedAssets)
@@ -199,25 +447,28 @@ public:
 		TSharedRef<FExtender> Extender(new FExtender());
 
 		bool AnyMaterials = false;
+		bool AnyBakeableAssets = false;
 		for (auto AssetIt = SelectedAssets.CreateConstIterator(); AssetIt; ++AssetIt)
 		{
 			const FAssetData& Asset = *AssetIt;
 			
 #if ENGINE_MINOR_VERSION < 1
 			AnyMaterials = AnyMaterials || (Asset.AssetClass == UMaterial::StaticClass()->GetFName());
+			AnyBakeableAssets = AnyBakeableAssets || (Asset.AssetClass == UNiagaraSystem::StaticClass()->GetFName()) || (Asset.AssetClass == UNiagaraUIBakedEffect::StaticClass()->GetFName());
 #else
 			AnyMaterials = AnyMaterials || (Asset.AssetClassPath == UMaterial::StaticClass()->GetClassPathName());
+			AnyBakeableAssets = AnyBakeableAssets || (Asset.AssetClassPath == UNiagaraSystem::StaticClass()->GetClassPathName()) || (Asset.AssetClassPath == UNiagaraUIBakedEffect::StaticClass()->GetClassPathName());
 #endif
 			
 		}
 
-		if (AnyMaterials)
+		if (AnyMaterials || AnyBakeableAssets)
 		{
 			Extender->AddMenuExtension(
 				"GetAssetActions",
 				EExtensionHook::After,
 				nullptr,
-				FMenuExtensionDelegate::CreateStatic(&FNiagaraUIContentBrowserExtension_Impl::CreateNiagaraUIFunctions, SelectedAssets));
+				FMenuExtensionDelegate::CreateStatic(&FNiagaraUIContentBrowserExtension_Impl::CreateNiagaraUIFunctions, SelectedAssets, AnyMaterials, AnyBakeableAssets));
 		}
 
 		return Extender;